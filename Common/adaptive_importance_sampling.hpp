@@ -0,0 +1,426 @@
+#ifndef COMMON_ADAPTIVE_IMPORTANCE_SAMPLING_HPP
+#define COMMON_ADAPTIVE_IMPORTANCE_SAMPLING_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include <boost/functional/hash.hpp>
+#include <bayesian/graph.hpp>
+#include <bayesian/utility.hpp>
+#include "compiled_network.hpp"
+#include "parallel_likelihood_weighting.hpp"
+#include "parallel_sampling.hpp"
+#include "thread_pool.hpp"
+
+namespace bn {
+namespace inference {
+
+// dvxCPTwKdvxTvO(AIS-BN, Cheng & Druzdzel, 2000)
+// Evidencȇc̏dvxCPTCEH[Abv(batch_size̃Tvupdate_num)
+// dݕtpx֊wKȂ߂ÂC̏dvxCPTsample_num̃Tv𐶐
+// lEvidence̐elzƂCthreshold / aritẙm؂グ
+// Ăяoparallel_likelihood_weightingƓ(~t̖₢킹stopping_ruleōs)
+class adaptive_importance_sampling {
+public:
+    using engine_type = std::mt19937;
+    using evidence_type = std::unordered_map<vertex_type, std::size_t>;
+    using result_type = std::unordered_map<vertex_type, std::vector<double>>;
+    using query_type = probability_query;
+
+    explicit adaptive_importance_sampling(
+        graph_t const& graph, std::size_t const thread_num = 0,
+        std::size_t const batch_size = 2500, std::size_t const update_num = 10, double const threshold = 0.1
+        )
+        : adaptive_importance_sampling(std::make_shared<compiled_network const>(graph), thread_num, batch_size, update_num, threshold)
+    {
+    }
+
+    explicit adaptive_importance_sampling(
+        std::shared_ptr<compiled_network const> network, std::size_t const thread_num = 0,
+        std::size_t const batch_size = 2500, std::size_t const update_num = 10, double const threshold = 0.1
+        )
+        : network_(std::move(network)), thread_num_(thread_num != 0 ? thread_num : thread_pool::default_thread_num()),
+          batch_size_(batch_size), update_num_(update_num), threshold_(threshold), engine_(make_engine<engine_type>()),
+          pool_(thread_num_ != 1 ? new thread_pool(thread_num_) : nullptr)
+    {
+        offset_.push_back(0);
+        for(std::size_t k = 0; k < network_->node_num(); ++k)
+            offset_.push_back(offset_.back() + network_->row_num(k) * network_->arity(k));
+    }
+
+    // eGW̍ăV[h(ČKvȏꍇ)
+    void seed(engine_type::result_type const value)
+    {
+        engine_.seed(value);
+    }
+
+    std::size_t thread_num() const
+    {
+        return thread_num_;
+    }
+
+    compiled_network const& network() const
+    {
+        return *network_;
+    }
+
+    // evidencẻł̊em[h̎㕪zԂ
+    result_type operator()(evidence_type const& evidence, std::size_t const sample_num)
+    {
+        auto const evidence_value = network_->make_evidence(evidence);
+
+        std::vector<std::uint32_t> active(network_->node_num());
+        for(std::size_t k = 0; k < active.size(); ++k) active[k] = static_cast<std::uint32_t>(k);
+
+        auto const table = learn(evidence_value, active);
+
+        std::vector<std::vector<double>> counts(thread_num_);
+        run(sample_num,
+            [this, &evidence_value, &active, &table, &counts](engine_type& engine, std::size_t const thread, std::size_t const num)
+            {
+                auto& count = counts[thread];
+                count.assign(network_->value_num(), 0.0);
+
+                std::vector<std::uint32_t> value(network_->node_num(), 0);
+                for(std::size_t s = 0; s < num; ++s)
+                {
+                    auto const weight = sample(engine, evidence_value, active, table, value.data());
+                    for(std::size_t k = 0; k < value.size(); ++k)
+                        count[network_->value_offset(k) + value[k]] += weight;
+                }
+            });
+
+        // XbhԍɃ}[WĐK
+        for(std::size_t t = 1; t < thread_num_; ++t)
+        {
+            for(std::size_t i = 0; i < counts[0].size(); ++i) counts[0][i] += counts[t][i];
+        }
+
+        result_type result;
+        for(std::size_t k = 0; k < network_->node_num(); ++k)
+        {
+            auto const first = counts[0].begin() + network_->value_offset(k);
+            std::vector<double> distribution(first, first + network_->arity(k));
+            normalize(distribution.data(), distribution.size());
+            result.insert(std::make_pair(network_->vertex(k), std::move(distribution)));
+        }
+
+        return result;
+    }
+
+    // ̖₢킹܂Ƃ߂ČvZ(parallel_likelihood_weighting::queryƓ`)
+    // Evidence₢킹͏dvxCPTsample_num̃TvL
+    std::vector<double> query(std::vector<query_type> const& queries, std::size_t const sample_num)
+    {
+        return query(queries, stopping_rule{0.0, 0.0, sample_num, sample_num}).probability;
+    }
+
+    // ~tŖ₢킹(parallel_likelihood_weighting::queryƓ`)
+    // EvidenceɏdvxCPTwKCrule.chunk_sizeTvOC
+    // SĂ̖₢킹95%MԂ̔rule.half_widthȉESSrule.min_essȏɂȂ邩C
+    // rule.max_sample_numɒB~߂
+    query_report query(std::vector<query_type> const& queries, stopping_rule const& rule)
+    {
+        std::vector<std::vector<std::size_t>> evidence;
+        std::vector<std::vector<std::size_t>> member;
+        std::unordered_map<std::vector<std::size_t>, std::size_t, boost::hash<std::vector<std::size_t>>> group_index;
+        for(std::size_t i = 0; i < queries.size(); ++i)
+        {
+            auto evidence_value = network_->make_evidence(queries[i].evidence);
+            auto const it = group_index.insert(std::make_pair(evidence_value, evidence.size())).first;
+            if(it->second == evidence.size())
+            {
+                evidence.push_back(std::move(evidence_value));
+                member.emplace_back();
+            }
+            member[it->second].push_back(i);
+        }
+
+        query_report report;
+        report.probability.assign(queries.size(), 0.0);
+        report.half_width.assign(queries.size(), 0.0);
+        report.ess.assign(queries.size(), 0.0);
+        report.sample_num.assign(queries.size(), 0);
+        for(std::size_t g = 0; g < evidence.size(); ++g)
+        {
+            auto const& evidence_value = evidence[g];
+
+            std::vector<std::size_t> roots;
+            for(std::size_t k = 0; k < evidence_value.size(); ++k)
+            {
+                if(evidence_value[k] != unobserved) roots.push_back(k);
+            }
+            for(auto const i : member[g]) roots.push_back(network_->position(queries[i].node));
+            auto const active = network_->ancestors(roots);
+
+            auto const table = learn(evidence_value, active);
+
+            // d݂̘a(w, w^2)Ɩ₢킹̘a(w I, w^2 I)
+            auto const& group = member[g];
+            double total = 0.0, total_square = 0.0;
+            std::vector<double> hit(group.size(), 0.0), hit_square(group.size(), 0.0);
+
+            std::size_t sample_num = 0;
+            bool converged = false;
+            while(!converged && sample_num < rule.max_sample_num)
+            {
+                auto const chunk = std::min(std::max<std::size_t>(rule.chunk_size, 1), rule.max_sample_num - sample_num);
+                sample_num += chunk;
+
+                // [w, w^2]ɑ[w I, w^2 I]₢킹ɕׂ
+                std::vector<std::vector<double>> sums(thread_num_);
+                run(chunk,
+                    [this, &queries, &group, &evidence_value, &active, &table, &sums](engine_type& engine, std::size_t const thread, std::size_t const num)
+                    {
+                        auto& sum = sums[thread];
+                        sum.assign(2 * (group.size() + 1), 0.0);
+
+                        std::vector<std::uint32_t> value(network_->node_num(), 0);
+                        for(std::size_t s = 0; s < num; ++s)
+                        {
+                            auto const weight = sample(engine, evidence_value, active, table, value.data());
+                            sum[0] += weight;
+                            sum[1] += weight * weight;
+                            for(std::size_t m = 0; m < group.size(); ++m)
+                            {
+                                auto const& q = queries[group[m]];
+                                if(value[network_->position(q.node)] != q.value) continue;
+                                sum[2 * (m + 1)] += weight;
+                                sum[2 * (m + 1) + 1] += weight * weight;
+                            }
+                        }
+                    });
+
+                // XbhԍɃ}[W
+                for(std::size_t t = 0; t < thread_num_; ++t)
+                {
+                    total += sums[t][0];
+                    total_square += sums[t][1];
+                    for(std::size_t m = 0; m < group.size(); ++m)
+                    {
+                        hit[m] += sums[t][2 * (m + 1)];
+                        hit_square[m] += sums[t][2 * (m + 1) + 1];
+                    }
+                }
+
+                auto const ess = total_square > 0.0 ? total * total / total_square : 0.0;
+                converged = ess >= rule.min_ess && total > 0.0;
+                for(std::size_t m = 0; m < group.size(); ++m)
+                {
+                    auto const i = group[m];
+                    auto const p = total > 0.0 ? hit[m] / total : 0.0;
+                    auto const variance = total > 0.0
+                        ? std::max(0.0, hit_square[m] * (1.0 - 2.0 * p) + p * p * total_square) / (total * total)
+                        : 0.0;
+
+                    report.probability[i] = p;
+                    report.half_width[i] = 1.96 * std::sqrt(variance);
+                    report.ess[i] = ess;
+                    report.sample_num[i] = sample_num;
+                    if(report.half_width[i] > rule.half_width) converged = false;
+                }
+            }
+        }
+
+        return report;
+    }
+
+private:
+    // dvxCPT(compiled_networkCPTƓ)
+    struct importance_table {
+        std::vector<double> probability;
+        std::vector<double> cumulative;
+    };
+
+
+    template<class Func>
+    void run(std::size_t const sample_num, Func func)
+    {
+        parallel_sampling(engine_, pool_.get(), thread_num_, sample_num, func);
+    }
+
+    static void normalize(double* const line, std::size_t const size)
+    {
+        double total = 0.0;
+        for(std::size_t j = 0; j < size; ++j) total += line[j];
+        if(total <= 0.0) return;
+        for(std::size_t j = 0; j < size; ++j) line[j] /= total;
+    }
+
+    void make_cumulative(importance_table& table) const
+    {
+        table.cumulative.resize(table.probability.size());
+        for(std::size_t k = 0; k < network_->node_num(); ++k)
+        {
+            auto const arity = network_->arity(k);
+            for(auto base = offset_[k]; base < offset_[k + 1]; base += arity)
+            {
+                double accumulate = 0.0;
+                for(std::size_t j = 0; j < arity; ++j)
+                {
+                    accumulate += table.probability[base + j];
+                    table.cumulative[base + j] = accumulate;
+                }
+            }
+        }
+    }
+
+    // dvxCPT1Tv𐶐Cd P(x, e) / Q(x) Ԃ
+    template<class Engine>
+    double sample(
+        Engine& engine, std::vector<std::size_t> const& evidence, std::vector<std::uint32_t> const& active,
+        importance_table const& table, std::uint32_t* const value
+        ) const
+    {
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+
+        double weight = 1.0;
+        for(auto const k : active)
+        {
+            auto const row = network_->row(k, value);
+            auto const original = network_->probability(k, row);
+            if(evidence[k] != unobserved)
+            {
+                value[k] = static_cast<std::uint32_t>(evidence[k]);
+                weight *= original[evidence[k]];
+                continue;
+            }
+
+            auto const base = offset_[k] + row * network_->arity(k);
+            auto const target = dist(engine);
+            auto const last = network_->arity(k) - 1;
+            std::uint32_t j = 0;
+            while(j < last && target >= table.cumulative[base + j]) ++j;
+
+            value[k] = j;
+            weight *= original[j] / table.probability[base + j];
+        }
+
+        return weight;
+    }
+
+    // Evidencẻł̏dvxCPTwK
+    importance_table learn(std::vector<std::size_t> const& evidence, std::vector<std::uint32_t> const& active)
+    {
+        auto const node_num = network_->node_num();
+
+        // dvxCPT̏l͌CPT
+        importance_table table;
+        table.probability.resize(offset_.back());
+        for(std::size_t k = 0; k < node_num; ++k)
+        {
+            std::copy(
+                network_->probability(k, 0), network_->probability(k, 0) + (offset_[k + 1] - offset_[k]),
+                table.probability.begin() + offset_[k]);
+        }
+
+        // wK̂Evidencȇc(EvidenceȊO)̂
+        std::vector<std::size_t> roots;
+        for(std::size_t k = 0; k < node_num; ++k)
+        {
+            if(evidence[k] != unobserved) roots.push_back(k);
+        }
+
+        std::vector<std::uint32_t> learning;
+        if(!roots.empty())
+        {
+            for(auto const k : network_->ancestors(roots))
+            {
+                if(evidence[k] == unobserved) learning.push_back(k);
+            }
+        }
+        if(learning.empty())
+        {
+            make_cumulative(table);
+            return table;
+        }
+
+        // Evidence̐e͈lzn߂
+        std::vector<bool> evidence_parent(node_num, false);
+        for(auto const e : roots)
+        {
+            for(auto p = network_->parent_begin(e); p != network_->parent_end(e); ++p) evidence_parent[*p] = true;
+        }
+
+        for(auto const k : learning)
+        {
+            auto const arity = network_->arity(k);
+            auto const cutoff = threshold_ / arity;
+            for(auto base = offset_[k]; base < offset_[k + 1]; base += arity)
+            {
+                auto const line = table.probability.data() + base;
+                for(std::size_t j = 0; j < arity; ++j)
+                {
+                    if(evidence_parent[k]) line[j] = 1.0 / arity;
+                    else if(line[j] < cutoff) line[j] = cutoff;
+                }
+                normalize(line, arity);
+            }
+        }
+        make_cumulative(table);
+
+        // wK a (b / a)^(u / update_num) ŉ
+        double const rate_first = 0.4, rate_last = 0.14;
+        for(std::size_t u = 0; u < update_num_; ++u)
+        {
+            std::vector<std::vector<double>> counts(thread_num_);
+            run(batch_size_,
+                [this, &evidence, &active, &learning, &table, &counts](engine_type& engine, std::size_t const thread, std::size_t const num)
+                {
+                    auto& count = counts[thread];
+                    count.assign(offset_.back(), 0.0);
+
+                    std::vector<std::uint32_t> value(network_->node_num(), 0);
+                    for(std::size_t s = 0; s < num; ++s)
+                    {
+                        auto const weight = sample(engine, evidence, active, table, value.data());
+                        for(auto const k : learning)
+                            count[offset_[k] + network_->row(k, value.data()) * network_->arity(k) + value[k]] += weight;
+                    }
+                });
+
+            for(std::size_t t = 1; t < thread_num_; ++t)
+            {
+                for(std::size_t i = 0; i < counts[0].size(); ++i) counts[0][i] += counts[t][i];
+            }
+
+            auto const rate = rate_first * std::pow(rate_last / rate_first, static_cast<double>(u) / update_num_);
+            for(auto const k : learning)
+            {
+                auto const arity = network_->arity(k);
+                for(auto base = offset_[k]; base < offset_[k + 1]; base += arity)
+                {
+                    auto const count = counts[0].data() + base;
+                    double total = 0.0;
+                    for(std::size_t j = 0; j < arity; ++j) total += count[j];
+                    if(total <= 0.0) continue;
+
+                    auto const line = table.probability.data() + base;
+                    for(std::size_t j = 0; j < arity; ++j)
+                        line[j] += rate * (count[j] / total - line[j]);
+                }
+            }
+            make_cumulative(table);
+        }
+
+        return table;
+    }
+
+    std::shared_ptr<compiled_network const> network_;
+    std::size_t thread_num_;
+    std::size_t batch_size_;
+    std::size_t update_num_;
+    double threshold_;
+    engine_type engine_;
+    std::unique_ptr<thread_pool> pool_;
+
+    std::vector<std::size_t> offset_; // ʒȕdvxCPT̐擪
+};
+
+} // namespace inference
+} // namespace bn
+
+#endif
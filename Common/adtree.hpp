@@ -0,0 +1,275 @@
+#ifndef COMMON_ADTREE_HPP
+#define COMMON_ADTREE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+#include "column_counter.hpp"
+#include "sample_table.hpp"
+
+namespace bn {
+
+// AD-tree(Moore & Lee, 1998)ɂtx̍
+// em[h́u鑮̒l̑gɈvsv̓xCŕpl̎q͎Ȃ(eZŋ߂)
+// vsleaf_thresholdsȉ̃m[h͓WJsԍ̗(leaf-list)̂ŁC
+// leaf_threshold傫ƍ͏ȂC₢킹͒xȂ
+// ̑傫͑ɑ΂ĎwIɑ̂ŁCm[hOɍmemory_limitoCg
+// ܂邩m߁CWJ܂Ȃleaf-listɁCleaf-list܂Ȃ΍炸ɑł؂
+// ł؂ʂ₢킹͍s̑(column_counter::count)œ(ǂʂ͕ςȂ)
+// column_counterƓ₢킹(count)ɍs𑖍
+class adtree {
+public:
+    explicit adtree(
+        sample_table const& table, std::size_t const leaf_threshold = 64, std::size_t const dense_limit = 1 << 20,
+        std::size_t const memory_limit = std::size_t(1) << 28
+        )
+        : rows_(table, dense_limit), leaf_threshold_(leaf_threshold), dense_limit_(dense_limit), memory_limit_(memory_limit)
+    {
+        if(rows_.row_num() > std::numeric_limits<std::uint32_t>::max())
+            throw std::runtime_error("error: Too many rows for adtree");
+
+        std::vector<std::uint32_t> all(rows_.row_num());
+        std::iota(all.begin(), all.end(), 0);
+        root_ = build(all, 0);
+
+        // L΂Ƃ̗]ȗeʂԂ
+        nodes_.shrink_to_fit();
+        varies_.shrink_to_fit();
+        children_.shrink_to_fit();
+        leaf_rows_.shrink_to_fit();
+    }
+
+    std::size_t node_num() const
+    {
+        return rows_.node_num();
+    }
+
+    std::size_t arity(std::size_t const node) const
+    {
+        return rows_.arity(node);
+    }
+
+    std::uint64_t sampling_size() const
+    {
+        return rows_.sampling_size();
+    }
+
+    // ̃m[h
+    std::size_t tree_size() const
+    {
+        return nodes_.size();
+    }
+
+    // g悻̃oCg(s̕\͊܂܂Ȃ)
+    std::size_t memory_usage() const
+    {
+        return nodes_.size() * sizeof(ad_node) + varies_.size() * sizeof(vary_node)
+            + children_.size() * sizeof(std::uint32_t) + leaf_rows_.size() * sizeof(std::uint32_t);
+    }
+
+    // childparents̕\𐔂(column_counter::countƓ`)
+    count_cells count(std::size_t const child, std::vector<std::size_t> const& parents) const
+    {
+        // AD-tree͑ԍ̏ɒH
+        std::vector<std::size_t> attributes(parents);
+        attributes.push_back(child);
+        std::sort(attributes.begin(), attributes.end());
+
+        // size[i] attributes[i..] ̕\̑傫(ԍtȂقǑ傫ΗO𓊂)
+        std::vector<std::uint64_t> size(attributes.size() + 1, 1);
+        for(std::size_t i = attributes.size(); i-- > 0;) size[i] = multiply_table_size(size[i + 1], rows_.arity(attributes[i]));
+
+        // 傫\͍s𑖍Đ
+        if(size[0] > dense_limit_) return rows_.count(child, parents);
+
+        // ł؂ɓ΍s𑖍Đ
+        std::vector<std::int64_t> table(static_cast<std::size_t>(size[0]), 0);
+        if(!contingency_table(attributes, size, 0, root_, table.data())) return rows_.count(child, parents);
+
+        // ȅ(Ō̐eł)ŎqŌƂԍ֕בւ
+        std::vector<std::uint64_t> stride(attributes.size());
+        {
+            std::uint64_t step = rows_.arity(child);
+            stride[std::find(attributes.begin(), attributes.end(), child) - attributes.begin()] = 1;
+            for(std::size_t i = parents.size(); i-- > 0;)
+            {
+                stride[std::find(attributes.begin(), attributes.end(), parents[i]) - attributes.begin()] = step;
+                step *= rows_.arity(parents[i]);
+            }
+        }
+
+        count_cells cells;
+        std::vector<std::size_t> value(attributes.size(), 0);
+        std::uint64_t index = 0;
+        for(std::size_t i = 0; i < table.size(); ++i)
+        {
+            if(table[i] != 0) cells.emplace_back(index, static_cast<std::uint64_t>(table[i]));
+
+            // Ō̑Jグ
+            for(std::size_t k = attributes.size(); k-- > 0;)
+            {
+                index += stride[k];
+                if(++value[k] < rows_.arity(attributes[k])) break;
+                index -= stride[k] * value[k];
+                value[k] = 0;
+            }
+        }
+
+        std::sort(cells.begin(), cells.end());
+        return cells;
+    }
+
+private:
+    // none: vs, truncated: memory_limitɎ܂炸Ȃ
+    enum : std::uint32_t { none = 0xffffffff, truncated = 0xfffffffe };
+
+    struct ad_node {
+        std::uint64_t count;
+        std::uint32_t start;  // ̃m[hWJŏ̑
+        std::uint32_t first;  // leafȂleaf_rows_́CłȂvaries_̐擪
+        std::uint32_t length; // leaf-list̍s
+        bool leaf;
+    };
+
+    struct vary_node {
+        std::uint32_t mcv;         // ŕpl(qȂ)
+        std::uint32_t first_child; // children_̐擪(l1Cvsnone)
+    };
+
+    // m[hȂtruncatedԂ
+    std::uint32_t build(std::vector<std::uint32_t> const& rows, std::size_t const start)
+    {
+        // ̃m[hleaf-listɂꍇƓWJꍇ(q͏)̑傫
+        auto const used = memory_usage() + sizeof(ad_node);
+        auto const leaf_size = rows.size() * sizeof(std::uint32_t);
+        auto expand_size = (rows_.node_num() - start) * sizeof(vary_node);
+        for(auto attribute = start; attribute < rows_.node_num(); ++attribute)
+            expand_size += rows_.arity(attribute) * sizeof(std::uint32_t);
+
+        auto const leaf_fits = used <= memory_limit_ && leaf_size <= memory_limit_ - used;
+        auto const expand_fits = used <= memory_limit_ && expand_size <= memory_limit_ - used;
+
+        ad_node node;
+        node.leaf = start < rows_.node_num() && (rows.size() <= leaf_threshold_ || !expand_fits);
+        if(node.leaf ? !leaf_fits : !expand_fits) return truncated;
+
+        auto const id = static_cast<std::uint32_t>(nodes_.size());
+        nodes_.push_back(ad_node());
+
+        node.count = 0;
+        for(auto const row : rows) node.count += rows_.weight(row);
+        node.start = static_cast<std::uint32_t>(start);
+        node.length = 0;
+
+        if(node.leaf)
+        {
+            node.first = static_cast<std::uint32_t>(leaf_rows_.size());
+            node.length = static_cast<std::uint32_t>(rows.size());
+            leaf_rows_.insert(leaf_rows_.end(), rows.begin(), rows.end());
+            nodes_[id] = node;
+            return id;
+        }
+
+        // q̓WJvaries_children_Lт̂ŁCɑSĂ̘̑gmۂ(memory_limit̊mF̑傫ōs)
+        node.first = static_cast<std::uint32_t>(varies_.size());
+        varies_.resize(varies_.size() + rows_.node_num() - start);
+        for(auto attribute = start; attribute < rows_.node_num(); ++attribute)
+        {
+            varies_[node.first + attribute - start].first_child = static_cast<std::uint32_t>(children_.size());
+            children_.resize(children_.size() + rows_.arity(attribute), none);
+        }
+        nodes_[id] = node;
+
+        for(auto attribute = start; attribute < rows_.node_num(); ++attribute)
+        {
+            std::vector<std::vector<std::uint32_t>> bucket(rows_.arity(attribute));
+            for(auto const row : rows) bucket[rows_.value(attribute, row)].push_back(row);
+
+            std::uint32_t mcv = 0;
+            for(std::uint32_t v = 1; v < bucket.size(); ++v)
+            {
+                if(bucket[v].size() > bucket[mcv].size()) mcv = v;
+            }
+            varies_[node.first + attribute - start].mcv = mcv;
+
+            auto const first_child = varies_[node.first + attribute - start].first_child;
+            for(std::uint32_t v = 0; v < bucket.size(); ++v)
+            {
+                if(v == mcv || bucket[v].empty()) continue;
+
+                auto const child = build(bucket[v], attribute + 1);
+                children_[first_child + v] = child;
+            }
+        }
+
+        return id;
+    }
+
+    // attributes[pos..] ̕\out։(ł؂ɓfalse)
+    bool contingency_table(
+        std::vector<std::size_t> const& attributes, std::vector<std::uint64_t> const& size,
+        std::size_t const pos, std::uint32_t const id, std::int64_t* const out
+        ) const
+    {
+        if(id == truncated) return false;
+
+        auto const& node = nodes_[id];
+        if(node.leaf)
+        {
+            for(auto i = node.first; i < node.first + node.length; ++i)
+            {
+                auto const row = leaf_rows_[i];
+
+                std::uint64_t index = 0;
+                for(auto k = pos; k < attributes.size(); ++k)
+                    index = index * rows_.arity(attributes[k]) + rows_.value(attributes[k], row);
+                out[index] += rows_.weight(row);
+            }
+            return true;
+        }
+
+        if(pos == attributes.size())
+        {
+            out[0] += node.count;
+            return true;
+        }
+
+        auto const attribute = attributes[pos];
+        auto const sub = static_cast<std::size_t>(size[pos + 1]);
+        auto const& vary = varies_[node.first + attribute - node.start];
+
+        for(std::uint32_t v = 0; v < rows_.arity(attribute); ++v)
+        {
+            auto const child = children_[vary.first_child + v];
+            if(v != vary.mcv && child != none && !contingency_table(attributes, size, pos + 1, child, out + v * sub))
+                return false;
+        }
+
+        // ŕpl = (̃m[hŎc̑𐔂) - (̒l̘a)
+        auto const mcv = out + vary.mcv * sub;
+        if(!contingency_table(attributes, size, pos + 1, id, mcv)) return false;
+        for(std::uint32_t v = 0; v < rows_.arity(attribute); ++v)
+        {
+            if(v == vary.mcv) continue;
+            for(std::size_t i = 0; i < sub; ++i) mcv[i] -= out[v * sub + i];
+        }
+        return true;
+    }
+
+    column_counter rows_;
+    std::size_t leaf_threshold_;
+    std::uint64_t dense_limit_;
+    std::size_t memory_limit_;
+
+    std::uint32_t root_;
+    std::vector<ad_node> nodes_;
+    std::vector<vary_node> varies_;
+    std::vector<std::uint32_t> children_;
+    std::vector<std::uint32_t> leaf_rows_;
+};
+
+} // namespace bn
+
+#endif
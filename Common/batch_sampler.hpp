@@ -0,0 +1,179 @@
+#ifndef COMMON_BATCH_SAMPLER_HPP
+#define COMMON_BATCH_SAMPLER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "compiled_network.hpp"
+
+// AVX2̌oH̓RpC̖߃Zbg̎w(/arch:AVX2, -mavx2)Ɉ˂炸֐PʂŗLɂCsCPU𒲂ׂđI
+// (AVX2̖CPUłXJ̌oHœ)
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define COMMON_BATCH_SAMPLER_AVX2
+#define COMMON_BATCH_SAMPLER_AVX2_TARGET
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define COMMON_BATCH_SAMPLER_AVX2
+#define COMMON_BATCH_SAMPLER_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace bn {
+
+// S`Tv܂Ƃ߂āCm[h(g|WJ)ɐTv
+// ʂ̓m[h̗(column(position)[sample])Ƃĕێ
+// CPUAVX2ɑΉĂCPT̍sIƗݐϊm̒T8/4Tvs(ʂ̓XJ̌oHƈv)
+class batch_sampler {
+public:
+    explicit batch_sampler(compiled_network const& network, std::size_t const block_size = 1024)
+        : network_(network), block_size_(block_size),
+          value_(network.node_num() * block_size), row_(block_size), uniform_(block_size), avx2_(has_avx2())
+    {
+        if(block_size == 0) throw std::runtime_error("error: block_size must be positive");
+    }
+
+    // CPUOSAVX2̌oHg邩
+    static bool has_avx2()
+    {
+#if defined(COMMON_BATCH_SAMPLER_AVX2) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if(info[0] < 7) return false;
+
+        // AVX̖߂OSɂYMMWX^̕ۑ(OSXSAVE, XCR0)m߂ĂAVX2̃rbg
+        __cpuid(info, 1);
+        if((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+        if((_xgetbv(0) & 6) != 6) return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#elif defined(COMMON_BATCH_SAMPLER_AVX2)
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#else
+        return false;
+#endif
+    }
+
+    std::size_t block_size() const
+    {
+        return block_size_;
+    }
+
+    std::uint32_t const* column(std::size_t const position) const
+    {
+        return value_.data() + position * block_size_;
+    }
+
+    // num(<= block_size)̃Tv𐶐
+    template<class Engine>
+    void sample(Engine& engine, std::size_t const num)
+    {
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+
+        for(std::size_t k = 0; k < network_.node_num(); ++k)
+        {
+            select_row(k, num);
+            for(std::size_t s = 0; s < num; ++s) uniform_[s] = dist(engine);
+            select_value(k, num);
+        }
+    }
+
+private:
+    // row_[s] =  e̒l * XgCh
+    void select_row(std::size_t const k, std::size_t const num)
+    {
+        std::fill(row_.begin(), row_.begin() + num, 0u);
+
+        auto stride = network_.stride_begin(k);
+        for(auto parent = network_.parent_begin(k); parent != network_.parent_end(k); ++parent, ++stride)
+        {
+            auto const column = value_.data() + *parent * block_size_;
+            std::size_t s = 0;
+#if defined(COMMON_BATCH_SAMPLER_AVX2)
+            if(avx2_) s = add_row_avx2(column, *stride, num);
+#endif
+            for(; s < num; ++s) row_[s] += column[s] * *stride;
+        }
+    }
+
+    // ݐϊmuniform_[s]ȉłl̐𐔂ĒlƂ(ݐϊm͒PȂ̂ŒTƈv)
+    void select_value(std::size_t const k, std::size_t const num)
+    {
+        auto const arity = network_.arity(k);
+        auto const last = arity - 1;
+        auto const cumulative = network_.cumulative(k, 0);
+        auto const output = value_.data() + k * block_size_;
+
+        std::size_t s = 0;
+#if defined(COMMON_BATCH_SAMPLER_AVX2)
+        if(avx2_) s = select_value_avx2(cumulative, arity, output, num);
+#endif
+        for(; s < num; ++s)
+        {
+            auto const line = cumulative + row_[s] * arity;
+            std::uint32_t j = 0;
+            while(j < last && uniform_[s] >= line[j]) ++j;
+            output[s] = j;
+        }
+    }
+
+#if defined(COMMON_BATCH_SAMPLER_AVX2)
+    // 8Tvrow_ɉCTvԂ
+    COMMON_BATCH_SAMPLER_AVX2_TARGET
+    std::size_t add_row_avx2(std::uint32_t const* const column, std::uint32_t const stride, std::size_t const num)
+    {
+        std::size_t s = 0;
+        __m256i const factor = _mm256_set1_epi32(static_cast<int>(stride));
+        for(; s + 8 <= num; s += 8)
+        {
+            __m256i const v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(column + s));
+            __m256i const r = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(row_.data() + s));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(row_.data() + s), _mm256_add_epi32(r, _mm256_mullo_epi32(v, factor)));
+        }
+        _mm256_zeroupper();
+        return s;
+    }
+
+    // 4Tvl߁CTvԂ
+    COMMON_BATCH_SAMPLER_AVX2_TARGET
+    std::size_t select_value_avx2(double const* const cumulative, std::uint32_t const arity, std::uint32_t* const output, std::size_t const num)
+    {
+        std::size_t s = 0;
+        __m128i const width = _mm_set1_epi32(static_cast<int>(arity));
+        for(; s + 4 <= num; s += 4)
+        {
+            __m256d const u = _mm256_loadu_pd(uniform_.data() + s);
+            __m128i const base = _mm_mullo_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(row_.data() + s)), width);
+
+            __m256i count = _mm256_setzero_si256();
+            for(std::uint32_t j = 0; j + 1 < arity; ++j)
+            {
+                __m128i const index = _mm_add_epi32(base, _mm_set1_epi32(static_cast<int>(j)));
+                __m256d const c = _mm256_i32gather_pd(cumulative, index, 8);
+                count = _mm256_sub_epi64(count, _mm256_castpd_si256(_mm256_cmp_pd(u, c, _CMP_GE_OQ)));
+            }
+
+            std::uint64_t lane[4];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lane), count);
+            for(std::size_t l = 0; l < 4; ++l) output[s + l] = static_cast<std::uint32_t>(lane[l]);
+        }
+        _mm256_zeroupper();
+        return s;
+    }
+#endif
+
+    compiled_network const& network_;
+    std::size_t block_size_;
+    std::vector<std::uint32_t> value_;
+    std::vector<std::uint32_t> row_;
+    std::vector<double> uniform_;
+    bool avx2_;
+};
+
+} // namespace bn
+
+#endif
@@ -0,0 +1,464 @@
+#ifndef COMMON_BIF_READER_HPP
+#define COMMON_BIF_READER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <bayesian/graph.hpp>
+#include "mapped_file.hpp"
+
+namespace bn {
+namespace serializer {
+
+// BIF`̓ǂݍ(serializer::bifƓʂԂ悤ɏĂ)
+// ł邱Ƃload_graph(path, bif_parser::check)Ŋm߂(ConvertToSnapshotGraphInfo--check)
+// 菑̎͂Ńt@C̈ʒu(|C^̑g)݂̂CO͕\ɓo^鎞std::stringɂ
+// 1xڂ̑variableC2xڂ̑probabilityǂނ̂ŁC錾͖̏Ȃ
+// probability̍s "(l, ...) m, ...;"C"default m, ...;"  "table m, ...;" 󂯕t
+// table̕т͎qłxCe͌قǑς
+class bif_reader {
+public:
+    std::tuple<graph_t, database_t> load(std::string const& path) const
+    {
+        mapped_file const file(path);
+        return parse(file.begin(), file.end());
+    }
+
+    std::tuple<graph_t, database_t> parse(char const* const first, char const* const last) const
+    {
+        parser p(first, last);
+        return p.run();
+    }
+
+private:
+    // t@C̋
+    struct token {
+        char const* first;
+        char const* last;
+
+        bool is(char const c) const
+        {
+            return last - first == 1 && *first == c;
+        }
+
+        bool is(char const* const word) const
+        {
+            auto const length = std::strlen(word);
+            return static_cast<std::size_t>(last - first) == length && std::equal(first, last, word);
+        }
+
+        bool operator==(token const& other) const
+        {
+            return last - first == other.last - other.first && std::equal(first, last, other.first);
+        }
+    };
+
+    struct token_hash {
+        std::size_t operator()(token const& t) const
+        {
+            // FNV-1a
+            std::uint64_t hash = 14695981039346656037ULL;
+            for(auto it = t.first; it != t.last; ++it)
+            {
+                hash ^= static_cast<unsigned char>(*it);
+                hash *= 1099511628211ULL;
+            }
+            return static_cast<std::size_t>(hash);
+        }
+    };
+
+    struct variable_type {
+        vertex_type vertex;
+        std::unordered_map<token, std::size_t, token_hash> value;
+    };
+
+    class parser {
+    public:
+        parser(char const* const first, char const* const last)
+            : first_(first), last_(last)
+        {
+        }
+
+        std::tuple<graph_t, database_t> run()
+        {
+            tokenize();
+
+            // variable
+            for(std::size_t i = 0; i < tokens_.size();)
+            {
+                if(tokens_[i].is("network"))
+                {
+                    auto name = at(i + 1);
+                    if(name.last - name.first >= 2 && *name.first == '"') ++name.first, --name.last;
+                    database_.graph_name = to_string(name);
+                    i = skip_block(i);
+                }
+                else if(tokens_[i].is("variable")) i = read_variable(i);
+                else i = skip_block(i);
+            }
+
+            // probability
+            for(std::size_t i = 0; i < tokens_.size();)
+            {
+                if(tokens_[i].is("probability")) i = read_probability(i);
+                else i = skip_block(i);
+            }
+
+            return std::make_tuple(std::move(graph_), std::move(database_));
+        }
+
+    private:
+        static bool is_symbol(char const c)
+        {
+            return c == '{' || c == '}' || c == '(' || c == ')' || c == '[' || c == ']' || c == '|' || c == ',' || c == ';';
+        }
+
+        static bool is_space(char const c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v';
+        }
+
+        void tokenize()
+        {
+            auto it = first_;
+            while(it != last_)
+            {
+                if(is_space(*it))
+                {
+                    ++it;
+                }
+                else if(*it == '/' && it + 1 != last_ && it[1] == '/')
+                {
+                    while(it != last_ && *it != '\n') ++it;
+                }
+                else if(*it == '/' && it + 1 != last_ && it[1] == '*')
+                {
+                    it += 2;
+                    while(it != last_ && !(*it == '*' && it + 1 != last_ && it[1] == '/')) ++it;
+                    if(it == last_) fail(it, "Unterminated comment");
+                    it += 2;
+                }
+                else if(*it == '"')
+                {
+                    // (property̒lȂ)͈p1̎ɂ
+                    auto const begin = it++;
+                    while(it != last_ && *it != '"') ++it;
+                    if(it == last_) fail(begin, "Unterminated string");
+                    tokens_.push_back(token{begin, ++it});
+                }
+                else if(is_symbol(*it))
+                {
+                    tokens_.push_back(token{it, it + 1});
+                    ++it;
+                }
+                else
+                {
+                    auto const begin = it;
+                    while(it != last_ && !is_space(*it) && !is_symbol(*it) && *it != '"') ++it;
+                    tokens_.push_back(token{begin, it});
+                }
+            }
+        }
+
+        // 錾1(ubN܂;܂)ǂݔ΂
+        std::size_t skip_block(std::size_t i) const
+        {
+            for(; i < tokens_.size(); ++i)
+            {
+                if(tokens_[i].is(';')) return i + 1;
+                if(tokens_[i].is('{')) break;
+            }
+            return i < tokens_.size() ? match_brace(i) : i;
+        }
+
+        std::size_t match_brace(std::size_t i) const
+        {
+            std::size_t depth = 0;
+            for(; i < tokens_.size(); ++i)
+            {
+                if(tokens_[i].is('{')) ++depth;
+                else if(tokens_[i].is('}') && --depth == 0) return i + 1;
+            }
+            fail(tokens_.back().last, "Unbalanced braces");
+            return i;
+        }
+
+        token const& at(std::size_t const i) const
+        {
+            if(i >= tokens_.size()) fail(last_, "Unexpected end of file");
+            return tokens_[i];
+        }
+
+        void expect(std::size_t const i, char const c) const
+        {
+            if(!at(i).is(c)) fail(at(i).first, std::string("'") + c + "' expected");
+        }
+
+        // variable NAME { type discrete [ N ] { V1, V2, ... }; property ...; }
+        std::size_t read_variable(std::size_t i)
+        {
+            auto const name = at(i + 1);
+            expect(i + 2, '{');
+            auto const end = match_brace(i + 2);
+
+            auto vertex = graph_.add_vertex();
+            variable_type variable;
+            variable.vertex = vertex;
+            bool typed = false;
+
+            for(i += 3; i + 1 < end;)
+            {
+                if(!tokens_[i].is("type"))
+                {
+                    i = skip_statement(i, end);
+                    continue;
+                }
+
+                expect(i + 2, '[');
+                auto const arity = read_integer(at(i + 3));
+                expect(i + 4, ']');
+                expect(i + 5, '{');
+
+                for(i += 6; !at(i).is('}'); ++i)
+                {
+                    if(at(i).is(',')) continue;
+                    variable.value.insert(std::make_pair(tokens_[i], variable.value.size()));
+                }
+                if(arity == 0) fail(name.first, "Type without values");
+                if(variable.value.size() != arity)
+                    fail(name.first, "Number of values does not match the declared arity");
+
+                vertex->selectable_num = arity;
+                typed = true;
+                i = skip_statement(i, end);
+            }
+
+            // l̐0̂܂܂̒_́CCPT̑傫TvOŊZY
+            if(!typed) fail(name.first, "Missing type");
+
+            database_.node_name[vertex->id] = to_string(name);
+            if(!variable_.insert(std::make_pair(name, std::move(variable))).second)
+                fail(name.first, "Duplicate variable");
+
+            return end;
+        }
+
+        std::size_t skip_statement(std::size_t i, std::size_t const end) const
+        {
+            while(i < end && !tokens_[i].is(';')) ++i;
+            return i + 1;
+        }
+
+        variable_type const& find_variable(token const& name) const
+        {
+            auto const it = variable_.find(name);
+            if(it == variable_.end()) fail(name.first, "Unknown variable");
+            return it->second;
+        }
+
+        // probability ( CHILD | P1, P2, ... ) { (v1, v2, ...) p, p, ...; table p, ...; default p, ...; }
+        std::size_t read_probability(std::size_t i)
+        {
+            expect(i + 1, '(');
+            auto const& child = find_variable(at(i + 2));
+
+            // 2xڂprobability͐e̕ӂd˂ĒCCPT㏑Ă܂
+            if(!probability_.insert(child.vertex).second) fail(at(i + 2).first, "Duplicate probability");
+
+            std::vector<variable_type const*> parents;
+            i += 3;
+            if(at(i).is('|'))
+            {
+                for(++i; !at(i).is(')'); ++i)
+                {
+                    if(tokens_[i].is(',')) continue;
+                    parents.push_back(&find_variable(tokens_[i]));
+                }
+            }
+            expect(i, ')');
+            expect(i + 1, '{');
+            auto const end = match_brace(i + 1);
+
+            for(auto const parent : parents) graph_.add_edge(parent->vertex, child.vertex);
+
+            std::size_t row_num = 1;
+            for(auto const parent : parents) row_num *= parent->vertex->selectable_num;
+
+            auto const arity = child.vertex->selectable_num;
+            std::vector<double> table(row_num * arity, 0.0);
+            std::vector<bool> assigned(row_num, false);
+
+            std::vector<double> line;
+            for(i += 2; i + 1 < end;)
+            {
+                auto const& head = tokens_[i];
+                if(head.is('('))
+                {
+                    // e̒lw肵s
+                    std::size_t row = 0;
+                    std::size_t p = 0;
+                    for(++i; !at(i).is(')'); ++i)
+                    {
+                        if(tokens_[i].is(',')) continue;
+                        if(p >= parents.size()) fail(tokens_[i].first, "Too many parent values");
+
+                        auto const it = parents[p]->value.find(tokens_[i]);
+                        if(it == parents[p]->value.end()) fail(tokens_[i].first, "Unknown value");
+                        row = row * parents[p]->vertex->selectable_num + it->second;
+                        ++p;
+                    }
+                    if(p != parents.size()) fail(tokens_[i].first, "Too few parent values");
+
+                    i = read_numbers(i + 1, end, line);
+                    if(line.size() != arity) fail(head.first, "Number of probabilities does not match the arity");
+                    std::copy(line.begin(), line.end(), table.begin() + row * arity);
+                    assigned[row] = true;
+                }
+                else if(head.is("default"))
+                {
+                    i = read_numbers(i + 1, end, line);
+                    if(line.size() != arity) fail(head.first, "Number of probabilities does not match the arity");
+                    for(std::size_t row = 0; row < row_num; ++row)
+                    {
+                        if(!assigned[row]) std::copy(line.begin(), line.end(), table.begin() + row * arity);
+                    }
+                    std::fill(assigned.begin(), assigned.end(), true);
+                }
+                else if(head.is("table"))
+                {
+                    i = read_numbers(i + 1, end, line);
+                    if(line.size() != row_num * arity) fail(head.first, "Number of probabilities does not match the table size");
+                    for(std::size_t j = 0; j < arity; ++j)
+                    {
+                        for(std::size_t row = 0; row < row_num; ++row) table[row * arity + j] = line[j * row_num + row];
+                    }
+                    std::fill(assigned.begin(), assigned.end(), true);
+                }
+                else i = skip_statement(i, end);
+            }
+
+            if(std::find(assigned.begin(), assigned.end(), false) != assigned.end())
+                fail(tokens_[end - 1].first, "Missing probability rows");
+
+            // _CPT֏
+            std::vector<std::size_t> select(parents.size(), 0);
+            for(std::size_t row = 0; row < row_num; ++row)
+            {
+                condition_t condition;
+                for(std::size_t p = 0; p < parents.size(); ++p)
+                    condition[parents[p]->vertex] = select[p];
+
+                child.vertex->cpt[condition] = std::vector<double>(table.begin() + row * arity, table.begin() + (row + 1) * arity);
+
+                for(std::size_t p = parents.size(); p-- > 0;)
+                {
+                    if(++select[p] < parents[p]->vertex->selectable_num) break;
+                    select[p] = 0;
+                }
+            }
+
+            return end;
+        }
+
+        // ;܂ł̐l̗(,؂)
+        std::size_t read_numbers(std::size_t i, std::size_t const end, std::vector<double>& numbers) const
+        {
+            numbers.clear();
+            for(; i < end && !tokens_[i].is(';'); ++i)
+            {
+                if(tokens_[i].is(',')) continue;
+                numbers.push_back(read_double(tokens_[i]));
+            }
+            return i + 1;
+        }
+
+        std::size_t read_integer(token const& t) const
+        {
+            std::size_t result = 0;
+            for(auto it = t.first; it != t.last; ++it)
+            {
+                if(*it < '0' || '9' < *it) fail(t.first, "Integer expected");
+                result = result * 10 + (*it - '0');
+            }
+            return result;
+        }
+
+        // 10ȉ(w\L܂)
+        // 2^5310̎w22ȉȂ1̏揜ZŐۂ߂DȊOstrtodɔC
+        double read_double(token const& t) const
+        {
+            static double const power[] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+            };
+
+            auto it = t.first;
+            bool const negative = it != t.last && *it == '-';
+            if(it != t.last && (*it == '-' || *it == '+')) ++it;
+
+            std::uint64_t mantissa = 0;
+            int exponent = 0, digits = 0;
+            for(; it != t.last && '0' <= *it && *it <= '9'; ++it, ++digits)
+                mantissa = mantissa * 10 + (*it - '0');
+            if(it != t.last && *it == '.')
+            {
+                for(++it; it != t.last && '0' <= *it && *it <= '9'; ++it, ++digits, --exponent)
+                    mantissa = mantissa * 10 + (*it - '0');
+            }
+            if(it != t.last && (*it == 'e' || *it == 'E'))
+            {
+                ++it;
+                bool const exponent_negative = it != t.last && *it == '-';
+                if(it != t.last && (*it == '-' || *it == '+')) ++it;
+
+                int value = 0;
+                for(; it != t.last && '0' <= *it && *it <= '9'; ++it) value = value * 10 + (*it - '0');
+                exponent += exponent_negative ? -value : value;
+            }
+
+            if(digits == 0 || it != t.last) fail(t.first, "Number expected");
+
+            if(digits <= 15 && -22 <= exponent && exponent <= 22)
+            {
+                auto const value = exponent < 0
+                    ? static_cast<double>(mantissa) / power[-exponent]
+                    : static_cast<double>(mantissa) * power[exponent];
+                return negative ? -value : value;
+            }
+
+            return std::strtod(to_string(t).c_str(), nullptr);
+        }
+
+        static std::string to_string(token const& t)
+        {
+            return std::string(t.first, t.last);
+        }
+
+        void fail(char const* const position, std::string const& message) const
+        {
+            auto const line = std::count(first_, position, '\n') + 1;
+            throw std::runtime_error("error: BIF parse error at line " + std::to_string(line) + " (" + message + ")");
+        }
+
+        char const* first_;
+        char const* last_;
+        std::vector<token> tokens_;
+
+        graph_t graph_;
+        database_t database_;
+        std::unordered_map<token, variable_type, token_hash> variable_;
+        std::unordered_set<vertex_type> probability_; // probabilityǂ񂾎q
+    };
+};
+
+} // namespace serializer
+} // namespace bn
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef COMMON_BITSET_GRAPH_HPP
+#define COMMON_BITSET_GRAPH_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <bayesian/graph.hpp>
+
+namespace bn {
+
+// אڍsrbgŎLOt(_graph_tvertex_list̏̔ԍň)
+// ӂ̗L̔O(1)ŁCeƎq͔ԍ̔zƂĘAɕԂ̂ŁC
+// wK]̓̃[vgraph_t̕ӂ̃XgH炸ɍς
+class bitset_graph {
+public:
+    explicit bitset_graph(std::size_t const node_num = 0)
+    {
+        reset(node_num);
+    }
+
+    // graph_t̕ӂʂ(ȅin_edges̏)
+    explicit bitset_graph(graph_t const& graph)
+    {
+        auto const& nodes = graph.vertex_list();
+        reset(nodes.size());
+
+        std::unordered_map<vertex_type, std::size_t> index;
+        for(std::size_t i = 0; i < nodes.size(); ++i) index[nodes[i]] = i;
+
+        for(std::size_t to = 0; to < nodes.size(); ++to)
+        {
+            for(auto const& edge : graph.in_edges(nodes[to]))
+                add_edge(index.at(graph.source(edge)), to);
+        }
+    }
+
+    // ӂ̖node_num_̃Otɂ
+    void reset(std::size_t const node_num)
+    {
+        node_num_ = node_num;
+        edge_num_ = 0;
+        words_ = (node_num + 63) / 64;
+        matrix_.assign(node_num * words_, 0);
+        parents_.assign(node_num, std::vector<std::size_t>());
+        children_.assign(node_num, std::vector<std::size_t>());
+    }
+
+    std::size_t node_num() const
+    {
+        return node_num_;
+    }
+
+    std::size_t edge_num() const
+    {
+        return edge_num_;
+    }
+
+    // fromto̕ӂ邩
+    bool has_edge(std::size_t const from, std::size_t const to) const
+    {
+        return (matrix_[from * words_ + to / 64] >> (to % 64)) & 1;
+    }
+
+    // 킸uvqĂ邩
+    bool is_connected(std::size_t const u, std::size_t const v) const
+    {
+        return has_edge(u, v) || has_edge(v, u);
+    }
+
+    std::vector<std::size_t> const& parents(std::size_t const node) const
+    {
+        return parents_[node];
+    }
+
+    std::vector<std::size_t> const& children(std::size_t const node) const
+    {
+        return children_[node];
+    }
+
+    // ɂӂ𑫂Ă͂ȂȂ(H̔sȂ)
+    void add_edge(std::size_t const from, std::size_t const to)
+    {
+        matrix_[from * words_ + to / 64] |= std::uint64_t(1) << (to % 64);
+        parents_[to].push_back(from);
+        children_[from].push_back(to);
+        ++edge_num_;
+    }
+
+    void erase_edge(std::size_t const from, std::size_t const to)
+    {
+        matrix_[from * words_ + to / 64] &= ~(std::uint64_t(1) << (to % 64));
+        parents_[to].erase(std::find(parents_[to].begin(), parents_[to].end(), from));
+        children_[from].erase(std::find(children_[from].begin(), children_[from].end(), to));
+        --edge_num_;
+    }
+
+    // graph̕ӂ̃Ot̕ӂŒu(graph̒_node_num()Ɠ)
+    void write(graph_t& graph) const
+    {
+        auto const& nodes = graph.vertex_list();
+        graph.erase_all_edge();
+        for(std::size_t to = 0; to < node_num_; ++to)
+        {
+            for(auto const from : parents_[to]) graph.add_edge(nodes[from], nodes[to]);
+        }
+    }
+
+private:
+    std::size_t node_num_;
+    std::size_t edge_num_;
+    std::size_t words_;
+    std::vector<std::uint64_t> matrix_;
+    std::vector<std::vector<std::size_t>> parents_;
+    std::vector<std::vector<std::size_t>> children_;
+};
+
+} // namespace bn
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef COMMON_BOUNDED_QUEUE_HPP
+#define COMMON_BOUNDED_QUEUE_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace bn {
+
+// eʕt̃XbhԃL[
+// t̂Ƃpush͋󂫂o܂ő҂CcloseɋɂȂpopfalseԂ
+// closepush͒l̂ĂfalseԂ(󂯎肪Ɏ~܂ꍇɑ҂Ȃ)
+template<class T>
+class bounded_queue {
+public:
+    explicit bounded_queue(std::size_t const capacity)
+        : capacity_(capacity), closed_(false)
+    {
+    }
+
+    bounded_queue(bounded_queue const&) = delete;
+    bounded_queue& operator=(bounded_queue const&) = delete;
+
+    bool push(T value)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this]{ return queue_.size() < capacity_ || closed_; });
+        if(closed_) return false;
+
+        queue_.push_back(std::move(value));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    bool pop(T& value)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]{ return !queue_.empty() || closed_; });
+        if(queue_.empty()) return false;
+
+        value = std::move(queue_.front());
+        queue_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    // ȏpushȂƂʒm
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+private:
+    std::size_t const capacity_;
+    bool closed_;
+    std::deque<T> queue_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+} // namespace bn
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef COMMON_CACHED_EVALUATION_HPP
+#define COMMON_CACHED_EVALUATION_HPP
+
+#include <memory>
+#include <stdexcept>
+#include <bayesian/graph.hpp>
+#include <bayesian/sampler.hpp>
+#include "family_score.hpp"
+
+namespace bn {
+namespace evaluation {
+
+// ƑXRÃLbVꏏɎsampler
+// CůwK֓nƁCcached_evaluatioñLbVŕ]ɓ
+// LbV͊wKreset_cacheō蒼(1sampler𓯎2̊wK֓nĂ͂ȂȂ)
+// wK̊ԂscopełsamplerĂ񂾃XbhɌѕtCcached_evaluation̓Xbh
+// ѕtăLbV(]ɃbN\̌Ȃ)
+template<class Score>
+class caching_sampler : public sampler {
+public:
+    using cache_type = family_score_cache<Score>;
+
+    // CsamplingƂ̃LbṼXbhɌѕt(ƌɖ߂)
+    // nullptrȂ牽ѕtȂ(bn::evaluation::mdlŊwKꍇ)
+    class scope {
+    public:
+        explicit scope(caching_sampler const* sampling)
+            : previous_sampler_(current_sampler()), previous_cache_(current_cache())
+        {
+            if(sampling)
+            {
+                current_cache() = &sampling->cache();
+                current_sampler() = sampling;
+            }
+        }
+
+        ~scope()
+        {
+            current_sampler() = previous_sampler_;
+            current_cache() = previous_cache_;
+        }
+
+        scope(scope const&) = delete;
+        scope& operator=(scope const&) = delete;
+
+    private:
+        sampler const* previous_sampler_;
+        cache_type* previous_cache_;
+    };
+
+    caching_sampler() = default;
+    caching_sampler(caching_sampler const&) = delete;
+    caching_sampler& operator=(caching_sampler const&) = delete;
+
+    void reset_cache(Score score)
+    {
+        cache_.reset(new cache_type(std::move(score)));
+    }
+
+    cache_type& cache() const
+    {
+        if(!cache_) throw std::runtime_error("error: The family score cache of the sampler is not prepared");
+        return *cache_;
+    }
+
+    // sampling̃XbhɌѕtcaching_sampler̂̂Ȃ炻̃LbVԂ
+    // EXCXꂽ̂╁ʂbn::samplerCѕtĂȂXbhȂO𓊂
+    static cache_type& cache_of(sampler const& sampling)
+    {
+        if(current_sampler() != &sampling)
+            throw std::runtime_error("error: cached_evaluation was given a sampler that is not bound to this thread (copied, sliced, plain bn::sampler or evaluated on another thread)");
+        return *current_cache();
+    }
+
+private:
+    // VS2013(v120)thread_localȂ̂ŁCPOD^̃|C^Ɍ__declspec(thread)őウ
+#if defined(_MSC_VER) && _MSC_VER < 1900
+    static sampler const*& current_sampler()
+    {
+        static __declspec(thread) sampler const* current = nullptr;
+        return current;
+    }
+
+    static cache_type*& current_cache()
+    {
+        static __declspec(thread) cache_type* current = nullptr;
+        return current;
+    }
+#else
+    static sampler const*& current_sampler()
+    {
+        static thread_local sampler const* current = nullptr;
+        return current;
+    }
+
+    static cache_type*& current_cache()
+    {
+        static thread_local cache_type* current = nullptr;
+        return current;
+    }
+#endif
+
+    std::unique_ptr<cache_type> cache_;
+};
+
+// CůwK(bn::learning::greedy, stepwise_structure_hcȂ)EvaluationAlgorithmɎg]
+// wK͕]ō\z (sampler, graph) ŌĂԂ̂ŁCLbV͊wKɓnsamplero
+// 1ŕςƑȊO̓LbVɓ̂ŁCOtŜ𐔂ɍς
+//
+//   caching_sampler<Score> sampler;           // wKɕʂ̂
+//   sampler.load_sample(graph.vertex_list());
+//   sampler.reset_cache(score);
+//   caching_sampler<Score>::scope const scope(&sampler);
+//   bn::learning::stepwise_structure_hc<cached_evaluation<Score>, ...> sshc(sampler);
+//
+// wK󂯎sampler𕡐ɁCscopeXbhŕ]֓nƂOƂ
+// (CůwK͂Ă邪CCu͕ۏ؂ĂȂ)DOΗO𓊂(`ɂ͂Ȃ)
+// lScore̒lŁCmdl_family_scoreȂbn::evaluation::mdlƓ`(2)ɂȂ
+template<class Score>
+class cached_evaluation {
+public:
+    using sampler_type = caching_sampler<Score>;
+
+    double operator()(sampler const& sampling, graph_t const& graph) const
+    {
+        return sampler_type::cache_of(sampling)(graph);
+    }
+};
+
+} // namespace evaluation
+} // namespace bn
+
+#endif
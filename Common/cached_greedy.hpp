@@ -0,0 +1,190 @@
+#ifndef COMMON_CACHED_GREEDY_HPP
+#define COMMON_CACHED_GREEDY_HPP
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <bayesian/graph.hpp>
+#include "bitset_graph.hpp"
+#include "family_score.hpp"
+#include "reachability_index.hpp"
+#include "thread_pool.hpp"
+
+namespace bn {
+namespace learning {
+
+// ƑXRÃLbVp×~@(ӂ̒ǉE폜E])
+// 1ŕς͍̂X2̉ƑȂ̂ŁC̉Ƒ݂̂ĕ]
+// XRA͏قǗǂ
+// thread_num1ȊOȂCe̕]ӂ̎n_ɕăXbhv[ŕɍs
+// Hreachability_indexO(1)(]͎n_̏o)ɂȂ
+// ]̃OtƓB\͓̍ǂނŁCƑXRÃLbV̓XbhSȂ̂ŁC
+// n_̍ŗǎn_̏ɔׂΒłƓ肪I΂
+template<class Score>
+class cached_greedy {
+public:
+    explicit cached_greedy(evaluation::family_score_cache<Score>& cache, std::size_t const thread_num = 1)
+        : cache_(cache), pool_(thread_num != 1 ? new thread_pool(thread_num) : nullptr)
+    {
+    }
+
+    // graph̕ӂƂCwKʂgraphɏ߂ăXRAԂ
+    double operator()(graph_t& graph)
+    {
+        auto const node_num = graph.vertex_list().size();
+
+        structure_ = bitset_graph(graph);
+        reachability_.reset(node_num);
+        for(std::size_t to = 0; to < node_num; ++to)
+        {
+            for(auto const from : structure_.parents(to)) reachability_.add_edge(from, to);
+        }
+
+        std::vector<double> family(node_num);
+        for(std::size_t i = 0; i < node_num; ++i) family[i] = cache_(i, structure_.parents(i));
+
+        std::vector<move> row_best(node_num);
+        while(true)
+        {
+            // n_̍ŗǎ
+            if(pool_)
+            {
+                auto const chunk = std::max<std::size_t>(1, (node_num + pool_->size() * 4 - 1) / (pool_->size() * 4));
+                for(std::size_t first = 0; first < node_num; first += chunk)
+                {
+                    auto const last = std::min(node_num, first + chunk);
+                    pool_->submit([this, &family, &row_best, first, last]
+                    {
+                        for(auto from = first; from < last; ++from) row_best[from] = best_move(from, family);
+                    });
+                }
+                pool_->wait();
+            }
+            else
+            {
+                for(std::size_t from = 0; from < node_num; ++from) row_best[from] = best_move(from, family);
+            }
+
+            // n_̏ɔׂ(PʂȂ̎)
+            auto best = row_best.empty() ? move{none, 0, 0, 0.0, 0.0, 0.0} : row_best[0];
+            for(std::size_t from = 1; from < node_num; ++from)
+            {
+                if(row_best[from].type != none && (best.type == none || row_best[from].delta < best.delta))
+                    best = row_best[from];
+            }
+
+            if(best.type == none) break;
+
+            switch(best.type)
+            {
+            case add:
+                link(best.from, best.to);
+                family[best.to] = best.to_score;
+                break;
+
+            case remove:
+                unlink(best.from, best.to);
+                family[best.to] = best.to_score;
+                break;
+
+            case reverse:
+                unlink(best.from, best.to);
+                link(best.to, best.from);
+                family[best.to] = best.to_score;
+                family[best.from] = best.from_score;
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        structure_.write(graph);
+
+        double result = 0.0;
+        for(auto const score : family) result += score;
+        return result;
+    }
+
+private:
+    enum move_type { none, add, remove, reverse };
+
+    struct move {
+        move_type type;
+        std::size_t from;
+        std::size_t to;
+        double delta;
+        double to_score;
+        double from_score;
+    };
+
+    // n_from̕ӂ̒ǉE폜E]̂ŗǂ̎(type == none)
+    move best_move(std::size_t const from, std::vector<double> const& family) const
+    {
+        // ۂߌ덷ɂ鉝h߁CPʂȉ͍̎̂Ȃ
+        double const epsilon = 1e-9;
+
+        move best{none, 0, 0, -epsilon, 0.0, 0.0};
+        for(std::size_t to = 0; to < structure_.node_num(); ++to)
+        {
+            if(from == to) continue;
+
+            if(structure_.has_edge(from, to))
+            {
+                // 폜
+                auto const removed = cache_(to, without(structure_.parents(to), from));
+                if(removed - family[to] < best.delta)
+                    best = move{remove, from, to, removed - family[to], removed, 0.0};
+
+                // ](fromtȏfromtoւ̌oHΕHɂȂ)
+                auto const reversed = cache_(from, with(structure_.parents(from), to));
+                auto const delta = removed - family[to] + reversed - family[from];
+                if(delta < best.delta && !reachability_.reverse_makes_cycle(from, to))
+                    best = move{reverse, from, to, delta, removed, reversed};
+            }
+            else if(!structure_.has_edge(to, from))
+            {
+                // ǉ(tofromւ̌oHΕHɂȂ)
+                auto const added = cache_(to, with(structure_.parents(to), from));
+                if(added - family[to] < best.delta && !reachability_.makes_cycle(from, to))
+                    best = move{add, from, to, added - family[to], added, 0.0};
+            }
+        }
+
+        return best;
+    }
+
+    static std::vector<std::size_t> with(std::vector<std::size_t> list, std::size_t const value)
+    {
+        list.push_back(value);
+        return list;
+    }
+
+    static std::vector<std::size_t> without(std::vector<std::size_t> list, std::size_t const value)
+    {
+        list.erase(std::find(list.begin(), list.end(), value));
+        return list;
+    }
+
+    void link(std::size_t const from, std::size_t const to)
+    {
+        structure_.add_edge(from, to);
+        reachability_.add_edge(from, to);
+    }
+
+    void unlink(std::size_t const from, std::size_t const to)
+    {
+        structure_.erase_edge(from, to);
+        reachability_.erase_edge(from, to);
+    }
+
+    evaluation::family_score_cache<Score>& cache_;
+    std::unique_ptr<thread_pool> pool_;
+    bitset_graph structure_;
+    reachability_index reachability_;
+};
+
+} // namespace learning
+} // namespace bn
+
+#endif
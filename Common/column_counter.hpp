@@ -0,0 +1,147 @@
+#ifndef COMMON_COLUMN_COUNTER_HPP
+#define COMMON_COLUMN_COUNTER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "sample_table.hpp"
+
+namespace bn {
+
+// \0łȂZ(ԍ, x)ԍɕׂ
+// ԍ e̒l̑g(Ō̐ełω) * qarity + q̒l
+using count_cells = std::vector<std::pair<std::uint64_t, std::uint64_t>>;
+
+// \̑傫sizearity|
+// Z̔ԍstd::uint64_tȂ̂ŁCςӂꂷ(ԍtȂ)Ƃ͗O𓊂
+// (ԍ͕\̑傫Ȃ̂ŁC傫܂Δԍ̌vZ͌ӂꂵȂ)
+inline std::uint64_t multiply_table_size(std::uint64_t const size, std::uint64_t const arity)
+{
+    if(arity != 0 && size > std::numeric_limits<std::uint64_t>::max() / arity)
+        throw std::runtime_error("error: Too many parent configurations to number the cells of a contingency table");
+    return size * arity;
+}
+
+// sample_tablewɓWJCtx N(x_i, pa_i) s̑Ő
+class column_counter {
+public:
+    using value_type = std::uint16_t;
+
+    explicit column_counter(sample_table const& table, std::size_t const dense_limit = 1 << 20)
+        : sampling_size_(table.sampling_size()), dense_limit_(dense_limit)
+    {
+        auto const node_num = table.node_num();
+        auto const row_num = table.row_num();
+
+        column_.assign(node_num, std::vector<value_type>(row_num));
+        weight_.resize(row_num);
+
+        std::vector<std::uint32_t> buffer;
+        std::size_t offset = 0;
+        for(std::size_t b = 0; b < table.block_num(); ++b)
+        {
+            auto const size = table.block(b).row_num;
+            table.decode_count(b, weight_.data() + offset);
+
+            buffer.resize(size);
+            for(std::size_t k = 0; k < node_num; ++k)
+            {
+                if(table.arity(k) > std::numeric_limits<value_type>::max())
+                    throw std::runtime_error("error: Too many values for column_counter");
+
+                table.decode_column(b, k, buffer.data());
+                std::copy(buffer.begin(), buffer.end(), column_[k].begin() + offset);
+            }
+            offset += size;
+        }
+
+        for(std::size_t k = 0; k < node_num; ++k)
+            arity_.push_back(table.arity(k));
+    }
+
+    std::size_t node_num() const
+    {
+        return arity_.size();
+    }
+
+    std::size_t arity(std::size_t const node) const
+    {
+        return arity_[node];
+    }
+
+    std::uint64_t sampling_size() const
+    {
+        return sampling_size_;
+    }
+
+    std::size_t row_num() const
+    {
+        return weight_.size();
+    }
+
+    value_type value(std::size_t const node, std::size_t const row) const
+    {
+        return column_[node][row];
+    }
+
+    std::uint64_t weight(std::size_t const row) const
+    {
+        return weight_[row];
+    }
+
+    // childparents̕\𐔂
+    count_cells count(std::size_t const child, std::vector<std::size_t> const& parents) const
+    {
+        std::uint64_t const width = arity_[child];
+        std::uint64_t size = width;
+        for(auto const parent : parents) size = multiply_table_size(size, arity_[parent]);
+
+        count_cells cells;
+        if(size <= dense_limit_)
+        {
+            std::vector<std::uint64_t> table(static_cast<std::size_t>(size), 0);
+            for(std::size_t r = 0; r < weight_.size(); ++r)
+                table[static_cast<std::size_t>(index(child, parents, r))] += weight_[r];
+
+            for(std::size_t i = 0; i < table.size(); ++i)
+            {
+                if(table[i] != 0) cells.emplace_back(i, table[i]);
+            }
+        }
+        else
+        {
+            // ȇgꍇ͏oẐݐ
+            std::unordered_map<std::uint64_t, std::uint64_t> table;
+            for(std::size_t r = 0; r < weight_.size(); ++r)
+                table[index(child, parents, r)] += weight_[r];
+
+            cells.assign(table.begin(), table.end());
+            std::sort(cells.begin(), cells.end());
+        }
+
+        return cells;
+    }
+
+private:
+    std::uint64_t index(std::size_t const child, std::vector<std::size_t> const& parents, std::size_t const row) const
+    {
+        std::uint64_t result = 0;
+        for(auto const parent : parents)
+            result = result * arity_[parent] + column_[parent][row];
+        return result * arity_[child] + column_[child][row];
+    }
+
+    std::vector<std::size_t> arity_;
+    std::vector<std::vector<value_type>> column_;
+    std::vector<std::uint64_t> weight_;
+    std::uint64_t sampling_size_;
+    std::uint64_t dense_limit_;
+};
+
+} // namespace bn
+
+#endif
@@ -0,0 +1,383 @@
+#ifndef COMMON_COMPILED_NETWORK_HPP
+#define COMMON_COMPILED_NETWORK_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include <boost/align/aligned_allocator.hpp>
+#include <bayesian/graph.hpp>
+
+namespace bn {
+namespace inference {
+
+// ϑĂȂƂ\Evidence̒l
+std::size_t const unobserved = std::numeric_limits<std::size_t>::max();
+
+// m_ւ̖₢킹: evidencẻł P(node = value)
+struct probability_query {
+    std::unordered_map<vertex_type, std::size_t> evidence;
+    vertex_type node;
+    std::size_t value;
+};
+
+} // namespace inference
+
+// graph_tƂCPTx镽Rȕ\
+// m[h̓g|WJɕג(ȉC̏̔ԍuʒuvƌĂ)C
+// ëʒuEXgChECPT͂ꂼAzɋl߂
+// 쐬͕ύXȂ̂ŁCXbh瓯ɎQƂĂ悢
+class compiled_network {
+public:
+    using buffer_type = std::vector<double, boost::alignment::aligned_allocator<double, 64>>;
+    using evidence_type = std::unordered_map<vertex_type, std::size_t>;
+
+    // _ɏ܂ꂽCPTǂݏoč
+    explicit compiled_network(graph_t const& graph)
+    {
+        make_order(graph);
+        make_table(graph,
+            [](vertex_type const& node, std::vector<vertex_type> const& parents, std::size_t const row_num)
+            {
+                return read_cpt(node, parents, row_num);
+            });
+    }
+
+    // graph̍\ƃTv̓xCPTŖސ肵č(_CPTɂ͐GȂ)
+    // Countercolumn_counter(m[hԍgraph_t::vertex_list()ł̔ԍ)
+    // TvɌȂe̒l̑g̍s͈lzƂ
+    template<class Counter>
+    compiled_network(graph_t const& graph, Counter const& counter)
+    {
+        make_order(graph);
+        make_table(graph,
+            [this, &counter](vertex_type const& node, std::vector<vertex_type> const& parents, std::size_t const row_num)
+            {
+                return estimate_cpt(counter, node, parents, row_num);
+            });
+    }
+
+    std::size_t node_num() const
+    {
+        return vertex_.size();
+    }
+
+    // Sm[h̒l̐̍v(JEgp̕RȔz̒)
+    std::size_t value_num() const
+    {
+        return value_offset_.back();
+    }
+
+    vertex_type const& vertex(std::size_t const position) const
+    {
+        return vertex_[position];
+    }
+
+    // graph_t::vertex_list()ł̔ԍ
+    std::size_t index(std::size_t const position) const
+    {
+        return index_[position];
+    }
+
+    std::size_t position(vertex_type const& node) const
+    {
+        return position_.at(node);
+    }
+
+    std::uint32_t arity(std::size_t const position) const
+    {
+        return arity_[position];
+    }
+
+    std::size_t value_offset(std::size_t const position) const
+    {
+        return value_offset_[position];
+    }
+
+    std::uint32_t const* parent_begin(std::size_t const position) const
+    {
+        return parent_position_.data() + parent_offset_[position];
+    }
+
+    std::uint32_t const* parent_end(std::size_t const position) const
+    {
+        return parent_position_.data() + parent_offset_[position + 1];
+    }
+
+    std::uint32_t const* stride_begin(std::size_t const position) const
+    {
+        return parent_stride_.data() + parent_offset_[position];
+    }
+
+    std::size_t row_num(std::size_t const position) const
+    {
+        return (cpt_offset_[position + 1] - cpt_offset_[position]) / arity_[position];
+    }
+
+    // e̒lCPT̍s߂(value͈ʒuň)
+    template<class Value>
+    std::size_t row(std::size_t const position, Value const* value) const
+    {
+        std::size_t result = 0;
+        for(auto p = parent_offset_[position]; p < parent_offset_[position + 1]; ++p)
+            result += value[parent_position_[p]] * parent_stride_[p];
+        return result;
+    }
+
+    double const* probability(std::size_t const position, std::size_t const row) const
+    {
+        return probability_.data() + cpt_offset_[position] + row * arity_[position];
+    }
+
+    double const* cumulative(std::size_t const position, std::size_t const row) const
+    {
+        return cumulative_.data() + cpt_offset_[position] + row * arity_[position];
+    }
+
+    // vertex_typeŗ^ꂽEvidenceʒuňzɒ
+    std::vector<std::size_t> make_evidence(evidence_type const& evidence) const
+    {
+        std::vector<std::size_t> result(node_num(), inference::unobserved);
+        for(auto const& e : evidence)
+            result[position(e.first)] = e.second;
+        return result;
+    }
+
+    // 1TvOɐC̏d(Evidence̖ޓx)Ԃ
+    template<class Engine, class Value>
+    double sample(Engine& engine, std::vector<std::size_t> const& evidence, Value* value) const
+    {
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+
+        double weight = 1.0;
+        for(std::size_t k = 0; k < arity_.size(); ++k)
+            weight *= sample_node(engine, dist, evidence, k, value);
+
+        return weight;
+    }
+
+    // activëʒu(ŁCeʒu̐eSĊ܂ނ)݂̂𐶐
+    // activeɊ܂܂Ȃʒuvalue͕ύXȂ
+    template<class Engine, class Value>
+    double sample(Engine& engine, std::vector<std::size_t> const& evidence, Value* value, std::vector<std::uint32_t> const& active) const
+    {
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+
+        double weight = 1.0;
+        for(auto const k : active)
+            weight *= sample_node(engine, dist, evidence, k, value);
+
+        return weight;
+    }
+
+    // positionsƂ̑c̈ʒuɕԂ
+    // (EvidenceƖ₢킹m[h̑cȊO͐_ʂɉeȂ̂ŐȂ)
+    std::vector<std::uint32_t> ancestors(std::vector<std::size_t> const& positions) const
+    {
+        std::vector<bool> marked(node_num(), false);
+        for(auto const position : positions) marked[position] = true;
+
+        // g|WJȂ̂ŁC납eֈ`1ōς
+        for(std::size_t k = node_num(); k-- > 0;)
+        {
+            if(!marked[k]) continue;
+            for(auto p = parent_begin(k); p != parent_end(k); ++p) marked[*p] = true;
+        }
+
+        std::vector<std::uint32_t> result;
+        for(std::size_t k = 0; k < node_num(); ++k)
+        {
+            if(marked[k]) result.push_back(static_cast<std::uint32_t>(k));
+        }
+        return result;
+    }
+
+private:
+    // ʒuk̒l߁Cd݂Ɋ|l(EvidencełȂ1)Ԃ
+    template<class Engine, class Value>
+    double sample_node(Engine& engine, std::uniform_real_distribution<double>& dist, std::vector<std::size_t> const& evidence, std::size_t const k, Value* value) const
+    {
+        auto const base = cpt_offset_[k] + row(k, value) * arity_[k];
+        if(evidence[k] != inference::unobserved)
+        {
+            value[k] = static_cast<Value>(evidence[k]);
+            return probability_[base + evidence[k]];
+        }
+
+        auto const target = dist(engine);
+        auto const last = arity_[k] - 1;
+        std::uint32_t j = 0;
+        while(j < last && target >= cumulative_[base + j]) ++j;
+        value[k] = static_cast<Value>(j);
+        return 1.0;
+    }
+
+    // g|WJ߂
+    void make_order(graph_t const& graph)
+    {
+        auto const& nodes = graph.vertex_list();
+
+        std::unordered_map<vertex_type, std::size_t> original;
+        for(std::size_t i = 0; i < nodes.size(); ++i)
+            original[nodes[i]] = i;
+
+        std::vector<std::size_t> in_degree(nodes.size());
+        for(std::size_t i = 0; i < nodes.size(); ++i)
+        {
+            in_degree[i] = graph.in_edges(nodes[i]).size();
+            if(in_degree[i] == 0) index_.push_back(i);
+        }
+
+        for(std::size_t k = 0; k < index_.size(); ++k)
+        {
+            for(auto const& edge : graph.out_edges(nodes[index_[k]]))
+            {
+                auto const child = original.at(graph.target(edge));
+                if(--in_degree[child] == 0) index_.push_back(child);
+            }
+        }
+
+        if(index_.size() != nodes.size())
+            throw std::runtime_error("error: Cannot compile a cyclic graph");
+
+        for(std::size_t k = 0; k < index_.size(); ++k)
+        {
+            vertex_.push_back(nodes[index_[k]]);
+            position_[vertex_.back()] = k;
+        }
+    }
+
+    // e̔zCPTl߂
+    // egraph_t::vertex_list()ł̔ԍɕ(ӂ̏ɂ炸eW͓\ɂȂ)C
+    // CPT̍s͍Ō̐ełω鏇ɕ
+    // reader(node, parents, row_num)͂̏ɕׂCPTS(row_num * arity)Ԃ
+    template<class Reader>
+    void make_table(graph_t const& graph, Reader reader)
+    {
+        parent_offset_.push_back(0);
+        value_offset_.push_back(0);
+        cpt_offset_.push_back(0);
+
+        for(std::size_t k = 0; k < vertex_.size(); ++k)
+        {
+            auto const& node = vertex_[k];
+            arity_.push_back(static_cast<std::uint32_t>(node->selectable_num));
+            value_offset_.push_back(value_offset_.back() + node->selectable_num);
+
+            std::vector<vertex_type> parents;
+            for(auto const& edge : graph.in_edges(node))
+                parents.push_back(graph.source(edge));
+            std::sort(parents.begin(), parents.end(),
+                [this](vertex_type const& lhs, vertex_type const& rhs)
+                {
+                    return index_[position_.at(lhs)] < index_[position_.at(rhs)];
+                });
+
+            std::vector<std::uint32_t> strides(parents.size());
+            // s̊Ԋuuint32_tŎ̂ŁC܂Ȃ(قĐ؂l߂)
+            std::size_t row_num = 1;
+            for(std::size_t p = parents.size(); p-- > 0;)
+            {
+                if(row_num > std::numeric_limits<std::uint32_t>::max())
+                    throw std::runtime_error("error: Too many parent configurations to compile the CPT of a node");
+                strides[p] = static_cast<std::uint32_t>(row_num);
+                row_num *= parents[p]->selectable_num;
+            }
+
+            for(std::size_t p = 0; p < parents.size(); ++p)
+            {
+                parent_position_.push_back(static_cast<std::uint32_t>(position_.at(parents[p])));
+                parent_stride_.push_back(strides[p]);
+            }
+            parent_offset_.push_back(parent_position_.size());
+
+            auto const table = reader(node, parents, row_num);
+            for(std::size_t row = 0; row < row_num; ++row)
+            {
+                double accumulate = 0.0;
+                for(std::size_t j = 0; j < node->selectable_num; ++j)
+                {
+                    auto const p = table[row * node->selectable_num + j];
+                    accumulate += p;
+                    probability_.push_back(p);
+                    cumulative_.push_back(accumulate);
+                }
+            }
+            cpt_offset_.push_back(probability_.size());
+        }
+    }
+
+    // es1x_CPTǂݏo
+    static std::vector<double> read_cpt(vertex_type const& node, std::vector<vertex_type> const& parents, std::size_t const row_num)
+    {
+        std::vector<double> table;
+        table.reserve(row_num * node->selectable_num);
+
+        std::vector<std::size_t> select(parents.size(), 0);
+        for(std::size_t row = 0; row < row_num; ++row)
+        {
+            evidence_type condition;
+            for(std::size_t p = 0; p < parents.size(); ++p)
+                condition[parents[p]] = select[p];
+
+            auto const& line = node->cpt[condition];
+            for(std::size_t j = 0; j < node->selectable_num; ++j)
+                table.push_back(line[j]);
+
+            for(std::size_t p = parents.size(); p-- > 0;)
+            {
+                if(++select[p] < parents[p]->selectable_num) break;
+                select[p] = 0;
+            }
+        }
+
+        return table;
+    }
+
+    // e̒l̑g̓xCPT߂
+    template<class Counter>
+    std::vector<double> estimate_cpt(Counter const& counter, vertex_type const& node, std::vector<vertex_type> const& parents, std::size_t const row_num) const
+    {
+        auto const arity = node->selectable_num;
+
+        std::vector<std::size_t> parent_index;
+        for(auto const& parent : parents) parent_index.push_back(index_[position_.at(parent)]);
+
+        std::vector<double> table(row_num * arity, 0.0);
+        for(auto const& cell : counter.count(index_[position_.at(node)], parent_index))
+            table[static_cast<std::size_t>(cell.first)] = static_cast<double>(cell.second);
+
+        for(std::size_t row = 0; row < row_num; ++row)
+        {
+            auto const line = table.begin() + row * arity;
+
+            double total = 0.0;
+            for(std::size_t j = 0; j < arity; ++j) total += line[j];
+
+            for(std::size_t j = 0; j < arity; ++j)
+                line[j] = total > 0.0 ? line[j] / total : 1.0 / arity;
+        }
+
+        return table;
+    }
+
+    std::vector<vertex_type> vertex_;
+    std::vector<std::size_t> index_;
+    std::unordered_map<vertex_type, std::size_t> position_;
+
+    std::vector<std::uint32_t> arity_;
+    std::vector<std::size_t> value_offset_;
+    std::vector<std::size_t> parent_offset_;
+    std::vector<std::uint32_t> parent_position_;
+    std::vector<std::uint32_t> parent_stride_;
+    std::vector<std::size_t> cpt_offset_;
+    buffer_type probability_;
+    buffer_type cumulative_;
+};
+
+} // namespace bn
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef COMMON_FACTOR_HPP
+#define COMMON_FACTOR_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "compiled_network.hpp"
+
+namespace bn {
+namespace inference {
+
+// ϐ(ʒȕ)̕\DŌ̕ϐłω
+struct factor {
+    std::vector<std::uint32_t> variable;
+    std::vector<double> table;
+};
+
+// ʒukCPTCqƐeϐƂqɒ
+inline factor make_cpt_factor(compiled_network const& network, std::size_t const k)
+{
+    factor result;
+    result.variable.assign(network.parent_begin(k), network.parent_end(k));
+    result.variable.push_back(static_cast<std::uint32_t>(k));
+    std::sort(result.variable.begin(), result.variable.end());
+
+    std::size_t size = 1;
+    for(auto const v : result.variable) size *= network.arity(v);
+    result.table.resize(size);
+
+    std::vector<std::uint32_t> value(network.node_num(), 0);
+    for(std::size_t i = 0; i < size; ++i)
+    {
+        result.table[i] = network.probability(k, network.row(k, value.data()))[value[k]];
+
+        for(std::size_t d = result.variable.size(); d-- > 0;)
+        {
+            auto const v = result.variable[d];
+            if(++value[v] < network.arity(v)) break;
+            value[v] = 0;
+        }
+    }
+
+    return result;
+}
+
+} // namespace inference
+} // namespace bn
+
+#endif
@@ -0,0 +1,180 @@
+#ifndef COMMON_FAMILY_SCORE_HPP
+#define COMMON_FAMILY_SCORE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <boost/functional/hash.hpp>
+#include <bayesian/graph.hpp>
+#include "bitset_graph.hpp"
+
+namespace bn {
+namespace evaluation {
+
+// Ƒ(qƂ̐eW)ɕłMDL(قǗǂ)
+//   MDL = - N_ijk log2(N_ijk / N_ij) + (log2 N / 2) q (r - 1)
+// 2(rbg)ŁCbn::evaluation::mdlƓ`ɂĂ肾CCu̒`͂ł͊m߂Ȃ
+// (PreliminaryExperiment--cached-evaluation͊wK̑OɒlׁCႦbn::evaluation::mdlɖ߂)
+// Countercount(child, parents)ŕ\0łȂZԂ
+template<class Counter>
+class mdl_family_score {
+public:
+    using counter_type = Counter;
+
+    explicit mdl_family_score(Counter const& counter)
+        : counter_(counter)
+    {
+    }
+
+    Counter const& counter() const
+    {
+        return counter_;
+    }
+
+    double operator()(std::size_t const child, std::vector<std::size_t> const& parents) const
+    {
+        auto const cells = counter_.count(child, parents);
+        auto const width = counter_.arity(child);
+
+        double parent_pattern = 1.0;
+        for(auto const parent : parents) parent_pattern *= counter_.arity(parent);
+
+        // e̒l̑gZ͘AĂ
+        double likelihood = 0.0;
+        for(std::size_t first = 0; first < cells.size();)
+        {
+            auto const pattern = cells[first].first / width;
+            auto last = first;
+            std::uint64_t total = 0;
+            while(last < cells.size() && cells[last].first / width == pattern) total += cells[last++].second;
+
+            for(auto i = first; i < last; ++i)
+            {
+                auto const n = static_cast<double>(cells[i].second);
+                likelihood += n * std::log2(n / total);
+            }
+            first = last;
+        }
+
+        auto const penalty = 0.5 * std::log2(static_cast<double>(counter_.sampling_size())) * parent_pattern * (width - 1);
+        return -likelihood + penalty;
+    }
+
+private:
+    Counter const& counter_;
+};
+
+// (q, \[gς݂̐eW) L[ƂƑXRÃLbV
+// Xbh瓯ɈĂ悢(L[̃nbVŃV[hɕăbN)
+template<class Score>
+class family_score_cache {
+public:
+    explicit family_score_cache(Score score, std::size_t const shard_num = 64)
+        : score_(std::move(score)), hit_(0), miss_(0)
+    {
+        for(std::size_t i = 0; i < shard_num; ++i)
+            shards_.push_back(std::unique_ptr<shard>(new shard()));
+    }
+
+    family_score_cache(family_score_cache const&) = delete;
+    family_score_cache& operator=(family_score_cache const&) = delete;
+
+    Score const& score() const
+    {
+        return score_;
+    }
+
+    std::size_t node_num() const
+    {
+        return score_.counter().node_num();
+    }
+
+    double operator()(std::size_t const child, std::vector<std::size_t> parents)
+    {
+        std::sort(parents.begin(), parents.end());
+
+        key_type key;
+        key.reserve(parents.size() + 1);
+        key.push_back(child);
+        key.insert(key.end(), parents.begin(), parents.end());
+
+        auto const hash = boost::hash<key_type>()(key);
+        auto& target = *shards_[hash % shards_.size()];
+        {
+            std::lock_guard<std::mutex> lock(target.mutex);
+            auto const it = target.table.find(key);
+            if(it != target.table.end())
+            {
+                ++hit_;
+                return it->second;
+            }
+        }
+
+        // vZ̓bN̊Oōs(L[𓯎ɌvZĂʂ͓)
+        ++miss_;
+        auto const value = score_(child, parents);
+
+        std::lock_guard<std::mutex> lock(target.mutex);
+        target.table.insert(std::make_pair(std::move(key), value));
+        return value;
+    }
+
+    // OtŜ̃XRA(ƑXRA̘a)
+    double operator()(graph_t const& graph)
+    {
+        auto const& nodes = graph.vertex_list();
+        std::unordered_map<vertex_type, std::size_t> index;
+        for(std::size_t i = 0; i < nodes.size(); ++i) index[nodes[i]] = i;
+
+        double result = 0.0;
+        for(std::size_t i = 0; i < nodes.size(); ++i)
+        {
+            std::vector<std::size_t> parents;
+            for(auto const& edge : graph.in_edges(nodes[i]))
+                parents.push_back(index.at(graph.source(edge)));
+            result += (*this)(i, std::move(parents));
+        }
+
+        return result;
+    }
+
+    double operator()(bitset_graph const& graph)
+    {
+        double result = 0.0;
+        for(std::size_t i = 0; i < graph.node_num(); ++i) result += (*this)(i, graph.parents(i));
+        return result;
+    }
+
+    std::size_t hit() const
+    {
+        return hit_;
+    }
+
+    std::size_t miss() const
+    {
+        return miss_;
+    }
+
+private:
+    using key_type = std::vector<std::size_t>;
+
+    struct shard {
+        std::mutex mutex;
+        std::unordered_map<key_type, double, boost::hash<key_type>> table;
+    };
+
+    Score score_;
+    std::vector<std::unique_ptr<shard>> shards_;
+    std::atomic<std::size_t> hit_;
+    std::atomic<std::size_t> miss_;
+};
+
+} // namespace evaluation
+} // namespace bn
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef COMMON_GRAPH_COMPARE_HPP
+#define COMMON_GRAPH_COMPARE_HPP
+
+#include <cmath>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <bayesian/graph.hpp>
+
+namespace bn {
+namespace serializer {
+
+// 2̓ǂݍ݌(Otƃf[^x[X)ׁCŏɌႢԂ(Ȃ󕶎)
+// _vertex_list̏ɑΉ(Tv̗̏ɂȂ̂ŁC̈ႢႢƂ)
+// ׂ̂̓m[hCl̐C(vertex_list̔ԍ̑g)CCPT̑SĂ̍s(m̍toleranceȉȂ瓯)
+// bif_readergraph_snapshotbn::serializer::bif̌ʂƔׂ邽߂Ɏg
+inline std::string graph_difference(
+    std::tuple<graph_t, database_t> const& lhs, std::tuple<graph_t, database_t> const& rhs, double const tolerance = 1e-12
+    )
+{
+    auto const& lhs_graph = std::get<0>(lhs);
+    auto const& rhs_graph = std::get<0>(rhs);
+    auto const& lhs_nodes = lhs_graph.vertex_list();
+    auto const& rhs_nodes = rhs_graph.vertex_list();
+    if(lhs_nodes.size() != rhs_nodes.size())
+        return "node num (" + std::to_string(lhs_nodes.size()) + " vs " + std::to_string(rhs_nodes.size()) + ")";
+
+    auto const name_of = [](database_t const& data, vertex_type const& node) -> std::string
+    {
+        auto const it = data.node_name.find(node->id);
+        return it != data.node_name.end() ? it->second : std::string();
+    };
+
+    std::unordered_map<vertex_type, std::size_t> lhs_index, rhs_index;
+    for(std::size_t i = 0; i < lhs_nodes.size(); ++i)
+    {
+        auto const lhs_name = name_of(std::get<1>(lhs), lhs_nodes[i]);
+        auto const rhs_name = name_of(std::get<1>(rhs), rhs_nodes[i]);
+        if(lhs_name != rhs_name)
+            return "name of node " + std::to_string(i) + " (" + lhs_name + " vs " + rhs_name + ")";
+        if(lhs_nodes[i]->selectable_num != rhs_nodes[i]->selectable_num)
+            return "arity of " + lhs_name + " (" + std::to_string(lhs_nodes[i]->selectable_num) + " vs " + std::to_string(rhs_nodes[i]->selectable_num) + ")";
+
+        lhs_index[lhs_nodes[i]] = i;
+        rhs_index[rhs_nodes[i]] = i;
+    }
+
+    auto const edge_set = [](graph_t const& graph, std::unordered_map<vertex_type, std::size_t> const& index)
+    {
+        std::set<std::pair<std::size_t, std::size_t>> edges;
+        for(auto const& edge : graph.edge_list())
+            edges.insert(std::make_pair(index.at(graph.source(edge)), index.at(graph.target(edge))));
+        return edges;
+    };
+    auto const lhs_edges = edge_set(lhs_graph, lhs_index);
+    auto const rhs_edges = edge_set(rhs_graph, rhs_index);
+    if(lhs_edges.size() != lhs_graph.edge_list().size() || rhs_edges.size() != rhs_graph.edge_list().size())
+        return "duplicate edges";
+    if(lhs_edges != rhs_edges)
+        return "edges (" + std::to_string(lhs_edges.size()) + " vs " + std::to_string(rhs_edges.size()) + " edges, or different endpoints)";
+
+    // CPT̍scondition_t(_  l)L[Ɏ̂ŁClhs̍s̃L[rhs̒_ɕtւĈ
+    for(std::size_t i = 0; i < lhs_nodes.size(); ++i)
+    {
+        auto const& lhs_cpt = lhs_nodes[i]->cpt;
+        auto const& rhs_cpt = rhs_nodes[i]->cpt;
+        auto const name = name_of(std::get<1>(lhs), lhs_nodes[i]);
+        if(lhs_cpt.size() != rhs_cpt.size())
+            return "CPT row num of " + name + " (" + std::to_string(lhs_cpt.size()) + " vs " + std::to_string(rhs_cpt.size()) + ")";
+
+        for(auto const& row : lhs_cpt)
+        {
+            condition_t condition;
+            for(auto const& select : row.first)
+                condition[rhs_nodes[lhs_index.at(select.first)]] = select.second;
+
+            auto const it = rhs_cpt.find(condition);
+            if(it == rhs_cpt.end()) return "CPT rows of " + name + " (a parent configuration is missing)";
+            if(row.second.size() != it->second.size()) return "CPT row width of " + name;
+            for(std::size_t k = 0; k < row.second.size(); ++k)
+            {
+                if(!(std::abs(row.second[k] - it->second[k]) <= tolerance))
+                    return "CPT of " + name + " (" + std::to_string(row.second[k]) + " vs " + std::to_string(it->second[k]) + ")";
+            }
+        }
+    }
+
+    return std::string();
+}
+
+} // namespace serializer
+} // namespace bn
+
+#endif
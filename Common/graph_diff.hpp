@@ -0,0 +1,102 @@
+#ifndef COMMON_GRAPH_DIFF_HPP
+#define COMMON_GRAPH_DIFF_HPP
+
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <boost/functional/hash.hpp>
+#include <bayesian/graph.hpp>
+
+namespace bn {
+
+// _̑g()L[ɂnbVW
+using vertex_pair = std::pair<vertex_type::element_type const*, vertex_type::element_type const*>;
+using vertex_pair_set = std::unordered_set<vertex_pair, boost::hash<vertex_pair>>;
+
+// 2̃Ot̕ӂ̍
+// Ot̕ӂ1xnbV\ɓCꂼ̕ӂ1x̂O(E)ŋ܂
+// ӂ̌킸ɔׂ̂ŁCt̕ӂ͏ɂɂȂ
+class graph_diff {
+public:
+    graph_diff(graph_t const& teacher, graph_t const& target)
+    {
+        vertex_pair_set teacher_edges, target_edges;
+        for(auto const& edge : teacher.edge_list()) teacher_edges.insert(key(teacher.source(edge), teacher.target(edge)));
+        for(auto const& edge : target.edge_list()) target_edges.insert(key(target.source(edge), target.target(edge)));
+
+        for(auto const& edge : teacher.edge_list())
+        {
+            auto const from = teacher.source(edge), to = teacher.target(edge);
+            auto const is_reverse = target_edges.count(key(to, from)) != 0;
+            auto const is_same = target_edges.count(key(from, to)) != 0;
+
+            if(is_reverse) reversed_.push_back(edge);
+            if(!is_same && !is_reverse) disappeared_.push_back(edge);
+        }
+
+        for(auto const& edge : target.edge_list())
+        {
+            auto const from = target.source(edge), to = target.target(edge);
+            if(teacher_edges.count(key(from, to)) == 0 && teacher_edges.count(key(to, from)) == 0)
+                appeared_.push_back(edge);
+        }
+    }
+
+    // teacher̕ӂ̂CtargetɌ킸(teacher̕ӂ̏)
+    std::vector<edge_type> const& disappeared() const
+    {
+        return disappeared_;
+    }
+
+    // target̕ӂ̂CteacherɌ킸(target̕ӂ̏)
+    std::vector<edge_type> const& appeared() const
+    {
+        return appeared_;
+    }
+
+    // teacher̕ӂ̂Ctargetɋt̕ӂ(teacher̕ӂ̏)
+    std::vector<edge_type> const& reversed() const
+    {
+        return reversed_;
+    }
+
+private:
+    static vertex_pair key(vertex_type const& from, vertex_type const& to)
+    {
+        return vertex_pair(from.get(), to.get());
+    }
+
+    std::vector<edge_type> disappeared_;
+    std::vector<edge_type> appeared_;
+    std::vector<edge_type> reversed_;
+};
+
+// _̑g̏d݂킸Ɉ\(ݏʂ̃XgȂǂ)
+// g΃XgŐɌꂽ̂gCg0Ƃ
+class edge_weight {
+public:
+    explicit edge_weight(std::vector<std::tuple<vertex_type, vertex_type, double>> const& list)
+    {
+        table_.reserve(list.size() * 2);
+        for(auto const& elem : list)
+        {
+            table_.insert(std::make_pair(vertex_pair(std::get<0>(elem).get(), std::get<1>(elem).get()), std::get<2>(elem)));
+            table_.insert(std::make_pair(vertex_pair(std::get<1>(elem).get(), std::get<0>(elem).get()), std::get<2>(elem)));
+        }
+    }
+
+    double operator()(vertex_type const& lhs, vertex_type const& rhs) const
+    {
+        auto const it = table_.find(vertex_pair(lhs.get(), rhs.get()));
+        return it != table_.end() ? it->second : 0.0;
+    }
+
+private:
+    std::unordered_map<vertex_pair, double, boost::hash<vertex_pair>> table_;
+};
+
+} // namespace bn
+
+#endif
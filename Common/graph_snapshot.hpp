@@ -0,0 +1,360 @@
+#ifndef COMMON_GRAPH_SNAPSHOT_HPP
+#define COMMON_GRAPH_SNAPSHOT_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <bayesian/graph.hpp>
+#include <bayesian/serializer/bif.hpp>
+#include "bif_reader.hpp"
+#include "graph_compare.hpp"
+#include "mapped_file.hpp"
+
+namespace bn {
+namespace serializer {
+
+// graph_tdatabase_t̃oCiXibvVbg(gq .bnsnap)
+// wb_̌ɌŒ蒷̔z8oCgEŕׂ̂ŁCǂݍ݂̓}bvt@C
+// ẑ܂ܓǂ݁C͂␔l̕ϊsȂ
+// graph_t͒_EӂCPT(condition_tL[ƂnbV\)Ŏ̂ŁCǂݍ݂ł
+// _ƕӂ𑫂CCPT̊escondition_tɍĎʂ(ǂݍ݂̑唼͂CPT̍蒼)
+//
+//   header                                   (magic "BNSNAPSH", version, ez̒)
+//   uint32 arity[node_num]
+//   uint32 edge[edge_num][2]                 (vertex_list̔ԍsource, targetDedge_list̏)
+//   uint32 parent_offset[node_num + 1]
+//   uint32 parent[edge_num]                  (CPT̍s̕т߂ȅ)
+//   uint64 cpt_offset[node_num + 1]
+//   double cpt[cpt_num]                      (s͌̐eقǑς)
+//   uint32 name_offset[node_num + 2]         (擪OtCĊem[h)
+//   char   name[name_size]
+class graph_snapshot {
+public:
+    enum : std::uint32_t { version = 1 };
+
+    std::tuple<graph_t, database_t> load(std::string const& path) const
+    {
+        mapped_file const file(path);
+        return parse(file.begin(), file.end());
+    }
+
+    // first8oCgEɒu(}bv擪͏ɖ)
+    std::tuple<graph_t, database_t> parse(char const* const first, char const* const last) const
+    {
+        auto const size = static_cast<std::size_t>(last - first);
+        if(size < sizeof(header_type) || std::memcmp(first, magic(), 8) != 0)
+            throw std::runtime_error("error: Not a graph snapshot");
+
+        header_type header;
+        std::memcpy(&header, first, sizeof(header));
+        if(header.version != version)
+            throw std::runtime_error("error: Unsupported graph snapshot version (" + std::to_string(header.version) + ")");
+
+        // z̘̒aӂꂵȂ悤Cvf͐Ƀt@C̑傫Ɣׂ
+        if(header.node_num > size / sizeof(std::uint32_t) || header.edge_num > size / sizeof(std::uint32_t) || header.cpt_num > size / sizeof(double))
+            throw std::runtime_error("error: Truncated graph snapshot");
+        layout const place(header);
+        if(size < place.total)
+            throw std::runtime_error("error: Truncated graph snapshot");
+
+        // t@C̔z𒼐ڎQƂ
+        auto const arity = reinterpret_cast<std::uint32_t const*>(first + place.arity);
+        auto const edge = reinterpret_cast<std::uint32_t const*>(first + place.edge);
+        auto const parent_offset = reinterpret_cast<std::uint32_t const*>(first + place.parent_offset);
+        auto const parent = reinterpret_cast<std::uint32_t const*>(first + place.parent);
+        auto const cpt_offset = reinterpret_cast<std::uint64_t const*>(first + place.cpt_offset);
+        auto const cpt = reinterpret_cast<double const*>(first + place.cpt);
+        auto const name_offset = reinterpret_cast<std::uint32_t const*>(first + place.name_offset);
+        auto const name = first + place.name;
+        check(header, arity, parent_offset, parent, cpt_offset, name_offset);
+
+        graph_t graph;
+        database_t database;
+        database.graph_name.assign(name + name_offset[0], name + name_offset[1]);
+
+        std::vector<vertex_type> nodes;
+        nodes.reserve(header.node_num);
+        for(std::uint32_t k = 0; k < header.node_num; ++k)
+        {
+            auto vertex = graph.add_vertex();
+            vertex->selectable_num = arity[k];
+            database.node_name[vertex->id].assign(name + name_offset[k + 1], name + name_offset[k + 2]);
+            nodes.push_back(std::move(vertex));
+        }
+
+        for(std::uint32_t e = 0; e < header.edge_num; ++e)
+        {
+            if(edge[2 * e] >= header.node_num || edge[2 * e + 1] >= header.node_num)
+                throw std::runtime_error("error: Broken graph snapshot (edge)");
+            graph.add_edge(nodes[edge[2 * e]], nodes[edge[2 * e + 1]]);
+        }
+        check_parent(header, edge, parent_offset, parent);
+
+        for(std::uint32_t k = 0; k < header.node_num; ++k)
+        {
+            auto const first_parent = parent + parent_offset[k];
+            auto const parent_num = parent_offset[k + 1] - parent_offset[k];
+
+            std::vector<std::size_t> select(parent_num, 0);
+            auto line = cpt + cpt_offset[k];
+            for(; line < cpt + cpt_offset[k + 1]; line += arity[k])
+            {
+                condition_t condition;
+                for(std::size_t p = 0; p < parent_num; ++p)
+                    condition[nodes[first_parent[p]]] = select[p];
+
+                nodes[k]->cpt[condition] = std::vector<double>(line, line + arity[k]);
+
+                for(std::size_t p = parent_num; p-- > 0;)
+                {
+                    if(++select[p] < arity[first_parent[p]]) break;
+                    select[p] = 0;
+                }
+            }
+        }
+
+        return std::make_tuple(std::move(graph), std::move(database));
+    }
+
+    // _CPT܂߂ďo(CPT̖_͈lzɂ)
+    void save(std::string const& path, graph_t const& graph, database_t const& database) const
+    {
+        auto const& nodes = graph.vertex_list();
+        std::unordered_map<vertex_type, std::uint32_t> index;
+        for(std::size_t k = 0; k < nodes.size(); ++k) index[nodes[k]] = static_cast<std::uint32_t>(k);
+
+        std::vector<std::uint32_t> arity, edge, parent_offset(1, 0), parent, name_offset(1, 0);
+        std::vector<std::uint64_t> cpt_offset(1, 0);
+        std::vector<double> cpt;
+        std::string name = database.graph_name;
+        name_offset.push_back(static_cast<std::uint32_t>(name.size()));
+
+        for(auto const& e : graph.edge_list())
+        {
+            edge.push_back(index.at(graph.source(e)));
+            edge.push_back(index.at(graph.target(e)));
+        }
+
+        for(auto const& node : nodes)
+        {
+            arity.push_back(static_cast<std::uint32_t>(node->selectable_num));
+
+            std::vector<vertex_type> parents;
+            for(auto const& e : graph.in_edges(node))
+            {
+                parents.push_back(graph.source(e));
+                parent.push_back(index.at(graph.source(e)));
+            }
+            parent_offset.push_back(static_cast<std::uint32_t>(parent.size()));
+
+            std::vector<std::size_t> select(parents.size(), 0);
+            do
+            {
+                condition_t condition;
+                for(std::size_t p = 0; p < parents.size(); ++p)
+                    condition[parents[p]] = select[p];
+
+                // operator[]͖sǉĂ܂̂ŁCoOtςȂ悤findŒT
+                auto const it = node->cpt.find(condition);
+                bool const found = it != node->cpt.end();
+                for(std::size_t j = 0; j < node->selectable_num; ++j)
+                    cpt.push_back(found && j < it->second.size() ? it->second[j] : 1.0 / node->selectable_num);
+            } while(next(select, parents));
+            cpt_offset.push_back(cpt.size());
+
+            auto const it = database.node_name.find(node->id);
+            if(it != database.node_name.end()) name += it->second;
+            name_offset.push_back(static_cast<std::uint32_t>(name.size()));
+        }
+
+        header_type header;
+        std::memcpy(header.magic, magic(), 8);
+        header.version = version;
+        header.node_num = static_cast<std::uint32_t>(nodes.size());
+        header.edge_num = static_cast<std::uint32_t>(graph.edge_list().size());
+        header.name_size = static_cast<std::uint32_t>(name.size());
+        header.cpt_num = cpt.size();
+
+        layout const place(header);
+        std::vector<char> buffer(place.total, 0);
+        std::memcpy(buffer.data(), &header, sizeof(header));
+        copy(buffer, place.arity, arity);
+        copy(buffer, place.edge, edge);
+        copy(buffer, place.parent_offset, parent_offset);
+        copy(buffer, place.parent, parent);
+        copy(buffer, place.cpt_offset, cpt_offset);
+        copy(buffer, place.cpt, cpt);
+        copy(buffer, place.name_offset, name_offset);
+        std::memcpy(buffer.data() + place.name, name.data(), name.size());
+
+        std::ofstream ofs(path, std::ios::binary);
+        if(!ofs.write(buffer.data(), buffer.size()))
+            throw std::runtime_error("error: Cannot write graph snapshot (" + path + ")");
+    }
+
+private:
+    struct header_type {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t node_num;
+        std::uint32_t edge_num;
+        std::uint32_t name_size;
+        std::uint64_t cpt_num;
+    };
+
+    // wb_狁߂ez̐擪ʒu
+    struct layout {
+        explicit layout(header_type const& header)
+        {
+            std::size_t position = sizeof(header_type);
+            auto const place = [&position](std::size_t const bytes)
+            {
+                auto const result = position;
+                position = (position + bytes + 7) / 8 * 8;
+                return result;
+            };
+
+            arity         = place(sizeof(std::uint32_t) * header.node_num);
+            edge          = place(sizeof(std::uint32_t) * header.edge_num * 2);
+            parent_offset = place(sizeof(std::uint32_t) * (header.node_num + 1));
+            parent        = place(sizeof(std::uint32_t) * header.edge_num);
+            cpt_offset    = place(sizeof(std::uint64_t) * (header.node_num + 1));
+            cpt           = place(sizeof(double) * static_cast<std::size_t>(header.cpt_num));
+            name_offset   = place(sizeof(std::uint32_t) * (header.node_num + 2));
+            name          = place(header.name_size);
+            total = position;
+        }
+
+        std::size_t arity, edge, parent_offset, parent, cpt_offset, cpt, name_offset, name, total;
+    };
+
+    // ez̒lgOɁCItZbgPŔ͈͓ɂCCPT̑傫e̒l̑g̐ƍƂm߂
+    static void check(
+        header_type const& header, std::uint32_t const* const arity, std::uint32_t const* const parent_offset,
+        std::uint32_t const* const parent, std::uint64_t const* const cpt_offset, std::uint32_t const* const name_offset
+        )
+    {
+        for(std::uint32_t k = 0; k < header.node_num + 1; ++k)
+        {
+            if(name_offset[k] > name_offset[k + 1])
+                throw std::runtime_error("error: Broken graph snapshot (name)");
+        }
+        if(name_offset[header.node_num + 1] > header.name_size)
+            throw std::runtime_error("error: Broken graph snapshot (name)");
+
+        if(parent_offset[0] != 0 || cpt_offset[0] != 0)
+            throw std::runtime_error("error: Broken graph snapshot (offset)");
+
+        for(std::uint32_t k = 0; k < header.node_num; ++k)
+        {
+            if(parent_offset[k] > parent_offset[k + 1] || parent_offset[k + 1] > header.edge_num)
+                throw std::runtime_error("error: Broken graph snapshot (parent)");
+            if(cpt_offset[k] > cpt_offset[k + 1] || cpt_offset[k + 1] > header.cpt_num)
+                throw std::runtime_error("error: Broken graph snapshot (cpt)");
+            if(arity[k] == 0)
+                throw std::runtime_error("error: Broken graph snapshot (arity)");
+
+            // CPT̑傫 = arity ~ earity̐(ςCPT̑傫𒴂ΉĂ)
+            auto const cpt_size = cpt_offset[k + 1] - cpt_offset[k];
+            std::uint64_t expected = arity[k];
+            for(auto p = parent_offset[k]; p < parent_offset[k + 1]; ++p)
+            {
+                if(parent[p] >= header.node_num)
+                    throw std::runtime_error("error: Broken graph snapshot (parent)");
+                if(arity[parent[p]] == 0 || expected > cpt_size / arity[parent[p]])
+                    throw std::runtime_error("error: Broken graph snapshot (cpt)");
+                expected *= arity[parent[p]];
+            }
+            if(expected != cpt_size)
+                throw std::runtime_error("error: Broken graph snapshot (cpt)");
+        }
+    }
+
+    // em[hparent[]Cedge[]ł̃m[hI_Ƃӂ̎n_()v邱Ƃm߂
+    // edge[]̒l͔͈͓ł邱
+    static void check_parent(
+        header_type const& header, std::uint32_t const* const edge,
+        std::uint32_t const* const parent_offset, std::uint32_t const* const parent
+        )
+    {
+        std::vector<std::vector<std::uint32_t>> sources(header.node_num);
+        for(std::uint32_t e = 0; e < header.edge_num; ++e)
+            sources[edge[2 * e + 1]].push_back(edge[2 * e]);
+
+        for(std::uint32_t k = 0; k < header.node_num; ++k)
+        {
+            auto& expected = sources[k];
+            std::vector<std::uint32_t> actual(parent + parent_offset[k], parent + parent_offset[k + 1]);
+            std::sort(expected.begin(), expected.end());
+            std::sort(actual.begin(), actual.end());
+            if(actual != expected || std::adjacent_find(actual.begin(), actual.end()) != actual.end())
+                throw std::runtime_error("error: Broken graph snapshot (parent does not match edge)");
+        }
+    }
+
+    static char const* magic()
+    {
+        return "BNSNAPSH";
+    }
+
+    template<class T>
+    static void copy(std::vector<char>& buffer, std::size_t const position, std::vector<T> const& source)
+    {
+        if(!source.empty()) std::memcpy(buffer.data() + position, source.data(), sizeof(T) * source.size());
+    }
+
+    static bool next(std::vector<std::size_t>& select, std::vector<vertex_type> const& parents)
+    {
+        for(std::size_t p = parents.size(); p-- > 0;)
+        {
+            if(++select[p] < parents[p]->selectable_num) return true;
+            select[p] = 0;
+        }
+        return false;
+    }
+};
+
+// BIF̓ǂݕ
+//   fast    : bif_reader()
+//   library : Cubn::serializer::bif
+//   check   : œǂŔׁCႦΗO𓊂(ʂbif_reader̂)
+enum class bif_parser { fast, library, check };
+
+inline std::tuple<graph_t, database_t> load_library_bif(std::string const& path)
+{
+    std::ifstream ifs(path);
+    if(!ifs) throw std::runtime_error("error: Cannot open " + path);
+    std::string const graph_data{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+    return bif().parse(graph_data.cbegin(), graph_data.cend());
+}
+
+// gqɏ]ăOtǂݍ(.bnsnap̓XibvVbgCȊOBIFparserœǂ)
+inline std::tuple<graph_t, database_t> load_graph(std::string const& path, bif_parser const parser = bif_parser::fast)
+{
+    auto const dot = path.find_last_of('.');
+    if(dot != std::string::npos && path.compare(dot, std::string::npos, ".bnsnap") == 0)
+        return graph_snapshot().load(path);
+
+    if(parser == bif_parser::library) return load_library_bif(path);
+
+    auto result = bif_reader().load(path);
+    if(parser == bif_parser::check)
+    {
+        auto const difference = graph_difference(result, load_library_bif(path));
+        if(!difference.empty())
+            throw std::runtime_error("error: bif_reader and bn::serializer::bif disagree on " + path + ": " + difference);
+    }
+    return result;
+}
+
+} // namespace serializer
+} // namespace bn
+
+#endif
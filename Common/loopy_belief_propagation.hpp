@@ -0,0 +1,497 @@
+#ifndef COMMON_LOOPY_BELIEF_PROPAGATION_HPP
+#define COMMON_LOOPY_BELIEF_PROPAGATION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <boost/functional/hash.hpp>
+#include <bayesian/graph.hpp>
+#include "batch_sampler.hpp"
+#include "compiled_network.hpp"
+#include "factor.hpp"
+#include "thread_pool.hpp"
+
+namespace bn {
+namespace inference {
+
+// qOtLoopy Belief Propagation
+// q(eCPT)ƕϐ̊Ԃ̕Ӗ̃bZ[WCӏɋl߂1{̔zɎ
+// qϐւ̃bZ[ẂC\̍Ō̕ϐAԖɓςƑ݂ŋ߂
+// (CPUAVX2ɑΉĂbatch_samplerƓsɑIсC4vfvZDȁς̂
+//  XJ̌oHƂ͍Ō̌Ⴂ邪CCPUł͌I)
+// cŗD揇ʂtꊇXVs
+//   eł͓̓bZ[Wςq̂ݐVbZ[WɌvZC̕ωʂq̎cƂ
+//   cőcpriority{ȏ(toleranceȏ)̈q݂̂𔽉fCc͌̂܂܎̔֎z
+//   fqɌqϐ̃bZ[Ŵ݂ɍXV
+// ̍őctoleranceɂȂ邩max_iterationŎ~߂
+// priority = 0ȂSĂ̌𖈉񔽉f铯XVɂȂ
+// fq͎cƈq̔ԍ݂̂Ō܂̂ŁCʂ̓Xbhɂ炸I
+// thread_num1ȂXbhv[炸CĂ񂾃XbhŌvZ
+class loopy_belief_propagation {
+public:
+    using evidence_type = std::unordered_map<vertex_type, std::size_t>;
+    using query_type = probability_query;
+
+    explicit loopy_belief_propagation(
+        graph_t const& graph, std::size_t const thread_num = 0,
+        double const tolerance = 1.0e-6, std::size_t const max_iteration = 100, double const damping = 0.0,
+        double const priority = 0.1
+        )
+        : loopy_belief_propagation(std::make_shared<compiled_network const>(graph), thread_num, tolerance, max_iteration, damping, priority)
+    {
+    }
+
+    explicit loopy_belief_propagation(
+        std::shared_ptr<compiled_network const> network, std::size_t const thread_num = 0,
+        double const tolerance = 1.0e-6, std::size_t const max_iteration = 100, double const damping = 0.0,
+        double const priority = 0.1
+        )
+        : network_(std::move(network)), pool_(thread_num != 1 ? new thread_pool(thread_num) : nullptr),
+          tolerance_(tolerance), max_iteration_(max_iteration), damping_(damping), priority_(priority), iteration_(0),
+          avx2_(batch_sampler::has_avx2())
+    {
+        // parallel_for̕(X[J[4{)ɍƗ̈
+        scratch_.resize(pool_ ? pool_->size() * 4 : 1);
+        make_graph();
+    }
+
+    compiled_network const& network() const
+    {
+        return *network_;
+    }
+
+    // O̐_ōs(max_iterationȂĂȂ)
+    std::size_t iteration() const
+    {
+        return iteration_;
+    }
+
+    // evidencẻł̑Sm[h̎㕪z(ߎ)Ԃ
+    std::unordered_map<vertex_type, std::vector<double>> operator()(evidence_type const& evidence)
+    {
+        auto const evidence_value = network_->make_evidence(evidence);
+
+        std::vector<std::size_t> all(network_->node_num());
+        for(std::size_t k = 0; k < all.size(); ++k) all[k] = k;
+        propagate(evidence_value, all);
+
+        std::unordered_map<vertex_type, std::vector<double>> result;
+        for(std::size_t k = 0; k < network_->node_num(); ++k)
+            result.insert(std::make_pair(network_->vertex(k), belief(evidence_value, k)));
+        return result;
+    }
+
+    // ̖₢킹ɓ(parallel_likelihood_weighting::queryƓ`)
+    // Evidence₢킹1̓`dœ
+    std::vector<double> query(std::vector<query_type> const& queries)
+    {
+        std::vector<std::vector<std::size_t>> evidence;
+        std::vector<std::vector<std::size_t>> member;
+        std::unordered_map<std::vector<std::size_t>, std::size_t, boost::hash<std::vector<std::size_t>>> group_index;
+        for(std::size_t i = 0; i < queries.size(); ++i)
+        {
+            auto evidence_value = network_->make_evidence(queries[i].evidence);
+            auto const it = group_index.insert(std::make_pair(evidence_value, evidence.size())).first;
+            if(it->second == evidence.size())
+            {
+                evidence.push_back(std::move(evidence_value));
+                member.emplace_back();
+            }
+            member[it->second].push_back(i);
+        }
+
+        std::vector<double> result(queries.size(), 0.0);
+        for(std::size_t g = 0; g < evidence.size(); ++g)
+        {
+            std::vector<std::size_t> roots;
+            for(std::size_t k = 0; k < evidence[g].size(); ++k)
+            {
+                if(evidence[g][k] != unobserved) roots.push_back(k);
+            }
+            for(auto const i : member[g]) roots.push_back(network_->position(queries[i].node));
+
+            auto const relevant = network_->ancestors(roots);
+            propagate(evidence[g], std::vector<std::size_t>(relevant.begin(), relevant.end()));
+
+            for(auto const i : member[g])
+                result[i] = belief(evidence[g], network_->position(queries[i].node))[queries[i].value];
+        }
+
+        return result;
+    }
+
+private:
+    // qEϐ̍XV̍Ɨ̈(ɊmۂȂ)
+    struct scratch_type {
+        std::vector<std::uint32_t> value;
+        std::vector<double> prefix;
+        std::vector<double> suffix;
+        std::vector<double> message;
+    };
+
+    // qOt
+    // e͈qfdԖڂ̕ϐƂсCbZ[Wmessage_offset_[e]ϐarity
+    void make_graph()
+    {
+        auto const node_num = network_->node_num();
+
+        edge_offset_.push_back(0);
+        message_offset_.push_back(0);
+        std::vector<std::vector<std::uint32_t>> variable_edge(node_num);
+        for(std::size_t k = 0; k < node_num; ++k)
+        {
+            factors_.push_back(make_cpt_factor(*network_, k));
+            for(auto const v : factors_.back().variable)
+            {
+                variable_edge[v].push_back(static_cast<std::uint32_t>(edge_variable_.size()));
+                edge_variable_.push_back(v);
+                edge_factor_.push_back(static_cast<std::uint32_t>(k));
+                message_offset_.push_back(message_offset_.back() + network_->arity(v));
+            }
+            edge_offset_.push_back(edge_variable_.size());
+        }
+
+        variable_offset_.push_back(0);
+        for(auto const& edges : variable_edge)
+        {
+            variable_edge_.insert(variable_edge_.end(), edges.begin(), edges.end());
+            variable_offset_.push_back(variable_edge_.size());
+        }
+    }
+
+    // relevanẗq݂̂œ`d(̈q̃bZ[W͈l̂܂)
+    void propagate(std::vector<std::size_t> const& evidence, std::vector<std::size_t> const& relevant)
+    {
+        auto const message_size = message_offset_.back();
+        to_variable_.assign(message_size, 1.0);
+        to_factor_.assign(message_size, 1.0);
+        next_.assign(message_size, 1.0);
+
+        is_relevant_.assign(factors_.size(), 0);
+        for(auto const f : relevant) is_relevant_[f] = 1;
+
+        // ϐqւ̃bZ[W̏l(Evidencê)
+        for(std::size_t v = 0; v < network_->node_num(); ++v)
+            update_variable(evidence, v, scratch_[0]);
+
+        // stale: ̓bZ[Wς̂ŌvZq
+        // candidate: next_ɖf̃bZ[W(cresidual)q
+        std::vector<std::size_t> stale(relevant), candidate, deferred, variables;
+        std::vector<char> is_stale(factors_.size(), 0), is_candidate(factors_.size(), 0), is_touched(network_->node_num(), 0);
+        std::vector<double> residual(factors_.size(), 0.0);
+        std::vector<double> changed(network_->node_num(), 0.0);
+        for(iteration_ = 0; iteration_ < max_iteration_; ++iteration_)
+        {
+            // qϐ(Cnext֏)
+            parallel_for(stale.size(),
+                [this, &stale, &residual](std::size_t const i, scratch_type& scratch)
+                {
+                    residual[stale[i]] = update_factor(stale[i], scratch);
+                });
+            for(auto const f : stale)
+            {
+                is_stale[f] = 0;
+                if(!is_candidate[f]) candidate.push_back(f);
+                is_candidate[f] = 1;
+            }
+
+            double max_residual = 0.0;
+            for(auto const f : candidate) max_residual = std::max(max_residual, residual[f]);
+            if(max_residual < tolerance_)
+            {
+                ++iteration_;
+                break;
+            }
+
+            // c̑傫q̂ݔf(tolerancê͎̂ƂĎ̂Ă)
+            auto const threshold = std::max(tolerance_, max_residual * priority_);
+            variables.clear();
+            deferred.clear();
+            for(auto const f : candidate)
+            {
+                if(residual[f] >= tolerance_ && residual[f] < threshold)
+                {
+                    deferred.push_back(f);
+                    continue;
+                }
+
+                is_candidate[f] = 0;
+                if(residual[f] < tolerance_) continue;
+
+                std::copy(
+                    next_.begin() + message_offset_[edge_offset_[f]], next_.begin() + message_offset_[edge_offset_[f + 1]],
+                    to_variable_.begin() + message_offset_[edge_offset_[f]]);
+                for(auto e = edge_offset_[f]; e < edge_offset_[f + 1]; ++e)
+                {
+                    if(!is_touched[edge_variable_[e]]) variables.push_back(edge_variable_[e]);
+                    is_touched[edge_variable_[e]] = 1;
+                }
+            }
+            candidate.swap(deferred);
+
+            // fqɌqϐq()
+            parallel_for(variables.size(),
+                [this, &evidence, &variables, &changed](std::size_t const i, scratch_type& scratch)
+                {
+                    changed[variables[i]] = update_variable(evidence, variables[i], scratch);
+                });
+
+            // ̓bZ[Wςq̔ŌvZ
+            stale.clear();
+            for(auto const v : variables)
+            {
+                is_touched[v] = 0;
+                if(changed[v] < tolerance_) continue;
+
+                for(auto i = variable_offset_[v]; i < variable_offset_[v + 1]; ++i)
+                {
+                    auto const f = edge_factor_[variable_edge_[i]];
+                    if(is_relevant_[f] && !is_stale[f]) stale.push_back(f);
+                    is_stale[f] = 1;
+                }
+            }
+        }
+    }
+
+    // qfeϐւ̃bZ[Wnext_ɌvZCωʂԂ
+    double update_factor(std::size_t const f, scratch_type& scratch)
+    {
+        auto const& fac = factors_[f];
+        auto const first = edge_offset_[f];
+        auto const width = fac.variable.size();
+
+        for(std::size_t d = 0; d < width; ++d)
+        {
+            auto const offset = message_offset_[first + d];
+            std::fill(next_.begin() + offset, next_.begin() + offset + network_->arity(fac.variable[d]), 0.0);
+        }
+
+        // \Ō̕ϐ̒ls(Arow_sizevf)Ɉ
+        //   Ō̕ϐ: s ~ ŌȊO̓̓bZ[W̐ 𑫂
+        //   ȊO:   sƍŌ̕ϐւ̓̓bZ[W̓ ~ ƍŌȊO̓̓bZ[W̐ 𑫂
+        // ȊO̐ς͍ŌȊO̕ϐ̑Oォ̗ݐϐςŋ߂
+        auto const last = width - 1;
+        auto const row_size = network_->arity(fac.variable[last]);
+        auto const last_input = to_factor_.data() + message_offset_[first + last];
+        auto const last_output = next_.data() + message_offset_[first + last];
+
+        auto& value = scratch.value;
+        auto& prefix = scratch.prefix;
+        auto& suffix = scratch.suffix;
+        value.assign(last, 0);
+        prefix.resize(width);
+        suffix.resize(width);
+        for(std::size_t row = 0; row < fac.table.size(); row += row_size)
+        {
+            prefix[0] = 1.0;
+            for(std::size_t d = 0; d < last; ++d)
+                prefix[d + 1] = prefix[d] * to_factor_[message_offset_[first + d] + value[d]];
+            suffix[last] = 1.0;
+            for(std::size_t d = last; d-- > 0;)
+                suffix[d] = suffix[d + 1] * to_factor_[message_offset_[first + d] + value[d]];
+
+            auto const line = fac.table.data() + row;
+            add_scaled(prefix[last], line, last_output, row_size);
+            if(last != 0)
+            {
+                auto const inner = dot(line, last_input, row_size);
+                for(std::size_t d = 0; d < last; ++d)
+                    next_[message_offset_[first + d] + value[d]] += inner * prefix[d] * suffix[d + 1];
+            }
+
+            for(std::size_t d = last; d-- > 0;)
+            {
+                if(++value[d] < network_->arity(fac.variable[d])) break;
+                value[d] = 0;
+            }
+        }
+
+        // KEƕω
+        double result = 0.0;
+        for(std::size_t d = 0; d < width; ++d)
+        {
+            auto const offset = message_offset_[first + d];
+            auto const arity = network_->arity(fac.variable[d]);
+            normalize(next_.data() + offset, arity);
+
+            for(std::size_t j = 0; j < arity; ++j)
+            {
+                auto& message = next_[offset + j];
+                message = (1.0 - damping_) * message + damping_ * to_variable_[offset + j];
+                result = std::max(result, std::abs(message - to_variable_[offset + j]));
+            }
+        }
+
+        return result;
+    }
+
+    // ϐveqւ̃bZ[WXVCωʂԂ
+    double update_variable(std::vector<std::size_t> const& evidence, std::size_t const v, scratch_type& scratch)
+    {
+        auto const arity = network_->arity(v);
+        auto const first = variable_offset_[v];
+        auto const last = variable_offset_[v + 1];
+
+        double result = 0.0;
+        auto& message = scratch.message;
+        message.resize(arity);
+        for(auto i = first; i < last; ++i)
+        {
+            auto const e = variable_edge_[i];
+            if(!is_relevant_[edge_factor_[e]]) continue;
+
+            for(std::uint32_t j = 0; j < arity; ++j)
+                message[j] = evidence[v] == unobserved || evidence[v] == j ? 1.0 : 0.0;
+
+            for(auto k = first; k < last; ++k)
+            {
+                if(k == i) continue;
+                auto const other = message_offset_[variable_edge_[k]];
+                for(std::uint32_t j = 0; j < arity; ++j) message[j] *= to_variable_[other + j];
+            }
+            normalize(message.data(), arity);
+
+            auto const offset = message_offset_[e];
+            for(std::uint32_t j = 0; j < arity; ++j)
+            {
+                result = std::max(result, std::abs(message[j] - to_factor_[offset + j]));
+                to_factor_[offset + j] = message[j];
+            }
+        }
+
+        return result;
+    }
+
+    // ϐv̐MO(Kς)
+    std::vector<double> belief(std::vector<std::size_t> const& evidence, std::size_t const v) const
+    {
+        auto const arity = network_->arity(v);
+        std::vector<double> result(arity);
+        for(std::uint32_t j = 0; j < arity; ++j)
+            result[j] = evidence[v] == unobserved || evidence[v] == j ? 1.0 : 0.0;
+
+        for(auto i = variable_offset_[v]; i < variable_offset_[v + 1]; ++i)
+        {
+            auto const offset = message_offset_[variable_edge_[i]];
+            for(std::uint32_t j = 0; j < arity; ++j) result[j] *= to_variable_[offset + j];
+        }
+
+        normalize(result.data(), arity);
+        return result;
+    }
+
+    static void normalize(double* const message, std::size_t const size)
+    {
+        double total = 0.0;
+        for(std::size_t j = 0; j < size; ++j) total += message[j];
+        if(total <= 0.0) return;
+        for(std::size_t j = 0; j < size; ++j) message[j] /= total;
+    }
+
+    //  line[j] * message[j]
+    double dot(double const* const line, double const* const message, std::size_t const size) const
+    {
+        double result = 0.0;
+        std::size_t j = 0;
+#if defined(COMMON_BATCH_SAMPLER_AVX2)
+        if(avx2_) j = dot_avx2(line, message, size, result);
+#endif
+        for(; j < size; ++j) result += line[j] * message[j];
+        return result;
+    }
+
+    // output[j] += scale * line[j]
+    void add_scaled(double const scale, double const* const line, double* const output, std::size_t const size) const
+    {
+        std::size_t j = 0;
+#if defined(COMMON_BATCH_SAMPLER_AVX2)
+        if(avx2_) j = add_scaled_avx2(scale, line, output, size);
+#endif
+        for(; j < size; ++j) output[j] += scale * line[j];
+    }
+
+#if defined(COMMON_BATCH_SAMPLER_AVX2)
+    // 4vfςresultɋ߁CvfԂ
+    COMMON_BATCH_SAMPLER_AVX2_TARGET
+    static std::size_t dot_avx2(double const* const line, double const* const message, std::size_t const size, double& result)
+    {
+        std::size_t j = 0;
+        __m256d sum = _mm256_setzero_pd();
+        for(; j + 4 <= size; j += 4)
+            sum = _mm256_add_pd(sum, _mm256_mul_pd(_mm256_loadu_pd(line + j), _mm256_loadu_pd(message + j)));
+
+        double lane[4];
+        _mm256_storeu_pd(lane, sum);
+        _mm256_zeroupper();
+        result = (lane[0] + lane[1]) + (lane[2] + lane[3]);
+        return j;
+    }
+
+    // 4vf݁CvfԂ
+    COMMON_BATCH_SAMPLER_AVX2_TARGET
+    static std::size_t add_scaled_avx2(double const scale, double const* const line, double* const output, std::size_t const size)
+    {
+        std::size_t j = 0;
+        __m256d const factor = _mm256_set1_pd(scale);
+        for(; j + 4 <= size; j += 4)
+        {
+            __m256d const o = _mm256_loadu_pd(output + j);
+            _mm256_storeu_pd(output + j, _mm256_add_pd(o, _mm256_mul_pd(factor, _mm256_loadu_pd(line + j))));
+        }
+        _mm256_zeroupper();
+        return j;
+    }
+#endif
+
+    // [0, size)Xbhv[ŕĎs(v[ΌĂ񂾃XbhŎs)
+    // Ԗɕʂ̍Ɨ̈n
+    template<class Func>
+    void parallel_for(std::size_t const size, Func func)
+    {
+        if(!pool_)
+        {
+            for(std::size_t i = 0; i < size; ++i) func(i, scratch_[0]);
+            return;
+        }
+
+        auto const chunk = std::max<std::size_t>(1, (size + pool_->size() * 4 - 1) / (pool_->size() * 4));
+        for(std::size_t first = 0, c = 0; first < size; first += chunk, ++c)
+        {
+            auto const last = std::min(size, first + chunk);
+            auto& scratch = scratch_[c];
+            pool_->submit([&func, &scratch, first, last]{ for(auto i = first; i < last; ++i) func(i, scratch); });
+        }
+        pool_->wait();
+    }
+
+    std::shared_ptr<compiled_network const> network_;
+    std::unique_ptr<thread_pool> pool_;
+    std::vector<scratch_type> scratch_;
+    double tolerance_;
+    std::size_t max_iteration_;
+    double damping_;
+    double priority_;
+    std::size_t iteration_;
+    bool avx2_;
+
+    std::vector<factor> factors_;
+    std::vector<std::size_t> edge_offset_;     // q̍ŏ̕
+    std::vector<std::uint32_t> edge_variable_; // ӂ̕ϐ
+    std::vector<std::uint32_t> edge_factor_;   // ӂ̈q
+    std::vector<std::size_t> message_offset_;  // Ӗ̃bZ[Ẅʒu
+    std::vector<std::size_t> variable_offset_; // ϐ̍ŏ̕(variable_edge_)
+    std::vector<std::uint32_t> variable_edge_;
+
+    std::vector<double> to_variable_;
+    std::vector<double> to_factor_;
+    std::vector<double> next_;
+    std::vector<char> is_relevant_;
+};
+
+} // namespace inference
+} // namespace bn
+
+#endif
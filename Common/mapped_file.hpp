@@ -0,0 +1,72 @@
+#ifndef COMMON_MAPPED_FILE_HPP
+#define COMMON_MAPPED_FILE_HPP
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/exceptions.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/system/error_code.hpp>
+
+namespace bn {
+
+// ǂݍݐpŃ}bvt@C(boost::interprocessɂ)
+// ̃t@C̓}bvCbegin() == end()ɂȂ
+// JȂC傫ȂC}bvłȂꍇstd::runtime_error𓊂
+class mapped_file {
+public:
+    explicit mapped_file(std::string const& path)
+        : data_(nullptr), size_(0)
+    {
+        boost::system::error_code error;
+        auto const file_size = boost::filesystem::file_size(path, error);
+        if(error)
+            throw std::runtime_error("error: Cannot open file (" + path + "): " + error.message());
+        if(file_size > static_cast<std::uintmax_t>(static_cast<std::size_t>(-1)))
+            throw std::runtime_error("error: File is too large to map (" + path + ")");
+        if(file_size == 0) return;
+
+        try
+        {
+            file_ = boost::interprocess::file_mapping(path.c_str(), boost::interprocess::read_only);
+            region_ = boost::interprocess::mapped_region(file_, boost::interprocess::read_only);
+        }
+        catch(boost::interprocess::interprocess_exception const& e)
+        {
+            throw std::runtime_error("error: Cannot map file (" + path + "): " + e.what());
+        }
+
+        data_ = static_cast<char const*>(region_.get_address());
+        size_ = region_.get_size();
+    }
+
+    mapped_file(mapped_file const&) = delete;
+    mapped_file& operator=(mapped_file const&) = delete;
+
+    char const* begin() const
+    {
+        return data_;
+    }
+
+    char const* end() const
+    {
+        return data_ + size_;
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+private:
+    boost::interprocess::file_mapping file_;
+    boost::interprocess::mapped_region region_;
+    char const* data_;
+    std::size_t size_;
+};
+
+} // namespace bn
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef COMMON_PAIRWISE_MUTUAL_INFORMATION_HPP
+#define COMMON_PAIRWISE_MUTUAL_INFORMATION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "sample_table.hpp"
+#include "thread_pool.hpp"
+#include "triangular_matrix.hpp"
+
+namespace bn {
+namespace evaluation {
+
+// Sm[h΂̑ݏʂ܂Ƃ߂ċ߂
+// TvwɃRs[ŁCm[h΂tile_size~tile_sizẽ^CɕC
+// e^Cɂčsrow_chunksȂS΂̓px\𓯎ɐ
+// px͑Tv܂ŏ̐^(32/64bit)Ő
+// oz(x/TvCȂ)ɂ
+//   I(X;Y) =  p(x,y) log(p(x,y) / (p(x)p(y)))  (p(x,y) = 0̍0Cΐ͎Rΐ)
+// ߂Dbn::evaluation::mutual_informationƂ̈vMutualInfoCalculator--checkŊm߂
+class pairwise_mutual_information {
+public:
+    explicit pairwise_mutual_information(std::size_t const tile_size = 16, std::size_t const row_chunk = 4096)
+        : tile_size_(tile_size), row_chunk_(row_chunk)
+    {
+    }
+
+    triangular_matrix<double> operator()(sample_table const& table, thread_pool& pool) const
+    {
+        if(table.sampling_size() <= std::numeric_limits<std::uint32_t>::max())
+            return compute<std::uint32_t>(table, pool);
+        else
+            return compute<std::uint64_t>(table, pool);
+    }
+
+private:
+    using value_type = std::uint16_t;
+
+    template<class Counter>
+    triangular_matrix<double> compute(sample_table const& table, thread_pool& pool) const
+    {
+        auto const node_num = table.node_num();
+        auto const row_num = table.row_num();
+        auto const total = static_cast<double>(table.sampling_size());
+
+        // w̃Rs[
+        std::vector<std::vector<value_type>> column(node_num, std::vector<value_type>(row_num));
+        std::vector<Counter> weight(row_num);
+        {
+            std::vector<std::uint32_t> buffer;
+            std::size_t offset = 0;
+            for(std::size_t b = 0; b < table.block_num(); ++b)
+            {
+                auto const size = table.block(b).row_num;
+                table.decode_count(b, weight.data() + offset);
+
+                buffer.resize(size);
+                for(std::size_t k = 0; k < node_num; ++k)
+                {
+                    if(table.arity(k) > std::numeric_limits<value_type>::max())
+                        throw std::runtime_error("error: Too many values for pairwise_mutual_information");
+
+                    table.decode_column(b, k, buffer.data());
+                    std::copy(buffer.begin(), buffer.end(), column[k].begin() + offset);
+                }
+                offset += size;
+            }
+        }
+
+        // ӊm
+        std::vector<std::vector<double>> marginal(node_num);
+        for(std::size_t k = 0; k < node_num; ++k)
+        {
+            marginal[k].assign(table.arity(k), 0.0);
+            for(std::size_t r = 0; r < row_num; ++r) marginal[k][column[k][r]] += weight[r];
+            for(auto& p : marginal[k]) p /= total;
+        }
+
+        // ^CɕvZ
+        triangular_matrix<double> result(node_num);
+        auto const tile_num = (node_num + tile_size_ - 1) / tile_size_;
+        for(std::size_t ti = 0; ti < tile_num; ++ti)
+        {
+            for(std::size_t tj = ti; tj < tile_num; ++tj)
+            {
+                pool.submit(
+                    [this, &table, &column, &weight, &marginal, &result, total, ti, tj]
+                    {
+                        process_tile<Counter>(table, column, weight, marginal, total, ti, tj, result);
+                    });
+            }
+        }
+        pool.wait();
+
+        return result;
+    }
+
+    template<class Counter>
+    void process_tile(
+        sample_table const& table,
+        std::vector<std::vector<value_type>> const& column,
+        std::vector<Counter> const& weight,
+        std::vector<std::vector<double>> const& marginal,
+        double const total,
+        std::size_t const ti, std::size_t const tj,
+        triangular_matrix<double>& result
+        ) const
+    {
+        auto const node_num = table.node_num();
+        auto const row_num = weight.size();
+
+        // ^C̃m[h΂ƁCꂼ̓px\̈ʒu
+        std::vector<std::pair<std::size_t, std::size_t>> pairs;
+        std::vector<std::size_t> offset(1, 0);
+        for(std::size_t i = ti * tile_size_; i < std::min(node_num, (ti + 1) * tile_size_); ++i)
+        {
+            for(std::size_t j = std::max(i + 1, tj * tile_size_); j < std::min(node_num, (tj + 1) * tile_size_); ++j)
+            {
+                pairs.emplace_back(i, j);
+                offset.push_back(offset.back() + table.arity(i) * table.arity(j));
+            }
+        }
+        if(pairs.empty()) return;
+
+        // srow_chunk_sC̊ԃ^C̗LbVɗ߂
+        std::vector<Counter> count(offset.back(), 0);
+        for(std::size_t first = 0; first < row_num; first += row_chunk_)
+        {
+            auto const last = std::min(row_num, first + row_chunk_);
+            for(std::size_t p = 0; p < pairs.size(); ++p)
+            {
+                auto const a = column[pairs[p].first].data();
+                auto const b = column[pairs[p].second].data();
+                auto const width = table.arity(pairs[p].second);
+                auto const cell = count.data() + offset[p];
+                for(std::size_t r = first; r < last; ++r)
+                    cell[a[r] * width + b[r]] += weight[r];
+            }
+        }
+
+        // px\瑊ݏʂ߂
+        for(std::size_t p = 0; p < pairs.size(); ++p)
+        {
+            auto const i = pairs[p].first;
+            auto const j = pairs[p].second;
+            auto const width = table.arity(j);
+
+            double mi = 0.0;
+            for(std::size_t a = 0; a < table.arity(i); ++a)
+            {
+                for(std::size_t b = 0; b < width; ++b)
+                {
+                    auto const c = count[offset[p] + a * width + b];
+                    if(c == 0) continue;
+
+                    auto const joint = c / total;
+                    mi += joint * std::log(joint / (marginal[i][a] * marginal[j][b]));
+                }
+            }
+            result(i, j) = mi;
+        }
+    }
+
+    std::size_t tile_size_;
+    std::size_t row_chunk_;
+};
+
+} // namespace evaluation
+} // namespace bn
+
+#endif
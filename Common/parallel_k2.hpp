@@ -0,0 +1,183 @@
+#ifndef COMMON_PARALLEL_K2_HPP
+#define COMMON_PARALLEL_K2_HPP
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include <bayesian/graph.hpp>
+#include <bayesian/utility.hpp>
+#include "bitset_graph.hpp"
+#include "family_score.hpp"
+#include "thread_pool.hpp"
+
+namespace bn {
+namespace learning {
+
+// ƑXRÃLbVpK2ASY
+// őOɂ钸_ƂCƑXRAłe1max_parent_num܂×~ɉ
+// _̐e̒T݂͌ɓƗȂ̂ŁC^ꍇ͒_ɁC
+// _X^[gł͏ɃXbhv[֓(ǂʂ̓XbhɈ˂Ȃ)
+// thread_num1ȂXbhv[炸CĂ񂾃XbhŏɒT
+// XRA͏قǗǂ
+template<class Score>
+class parallel_k2 {
+public:
+    using engine_type = std::mt19937;
+
+    parallel_k2(evaluation::family_score_cache<Score>& cache, std::size_t const max_parent_num, std::size_t const thread_num = 0)
+        : cache_(cache), max_parent_num_(max_parent_num), pool_(thread_num != 1 ? new thread_pool(thread_num) : nullptr), engine_(make_engine<engine_type>())
+    {
+    }
+
+    void seed(engine_type::result_type const value)
+    {
+        engine_.seed(value);
+    }
+
+    // ordervertex_list̔ԍ̕(̒_قǐeɂȂ)
+    // wKʂgraphɏŃXRAԂ
+    double operator()(graph_t& graph, std::vector<std::size_t> const& order)
+    {
+        auto const node_num = graph.vertex_list().size();
+        check_order(order, node_num);
+
+        std::vector<std::vector<std::size_t>> parents(node_num);
+        std::vector<double> family(node_num);
+        for_each_index(node_num, [this, &order, &parents, &family](std::size_t const i)
+        {
+            family[order[i]] = search(order, i, parents[order[i]]);
+        });
+
+        return write(graph, parents, family);
+    }
+
+    // _ȏrestart_numCꂼK2ɍsčłǂ\graphɏ
+    double random_restart(graph_t& graph, std::size_t const restart_num)
+    {
+        auto const node_num = graph.vertex_list().size();
+        if(restart_num == 0) throw std::runtime_error("error: restart_num must be positive");
+
+        // ͐ɐeGW
+        std::vector<std::vector<std::size_t>> orders(restart_num, std::vector<std::size_t>(node_num));
+        for(auto& order : orders)
+        {
+            std::iota(order.begin(), order.end(), 0);
+            std::shuffle(order.begin(), order.end(), engine_);
+        }
+
+        std::vector<std::vector<std::vector<std::size_t>>> parents(restart_num, std::vector<std::vector<std::size_t>>(node_num));
+        std::vector<std::vector<double>> family(restart_num, std::vector<double>(node_num));
+        std::vector<double> total(restart_num, 0.0);
+        for_each_index(restart_num, [this, &orders, &parents, &family, &total](std::size_t const r)
+        {
+            for(std::size_t i = 0; i < orders[r].size(); ++i)
+            {
+                auto const node = orders[r][i];
+                family[r][node] = search(orders[r], i, parents[r][node]);
+            }
+            for(auto const score : family[r]) total[r] += score;
+        });
+
+        // ɔׂ(XRAȂ̏)
+        std::size_t best = 0;
+        for(std::size_t r = 1; r < restart_num; ++r)
+        {
+            if(total[r] < total[best]) best = r;
+        }
+
+        return write(graph, parents[best], family[best]);
+    }
+
+private:
+    // func(0), ..., func(num - 1)Xbhv[(΂̃Xbhŏ)s
+    template<class Func>
+    void for_each_index(std::size_t const num, Func const& func)
+    {
+        if(!pool_)
+        {
+            for(std::size_t i = 0; i < num; ++i) func(i);
+            return;
+        }
+
+        for(std::size_t i = 0; i < num; ++i)
+            pool_->submit([&func, i]{ func(i); });
+        pool_->wait();
+    }
+
+    static void check_order(std::vector<std::size_t> const& order, std::size_t const node_num)
+    {
+        std::vector<char> seen(node_num, 0);
+        if(order.size() != node_num)
+            throw std::runtime_error("error: The order must contain every node exactly once");
+        for(auto const node : order)
+        {
+            if(node >= node_num || seen[node])
+                throw std::runtime_error("error: The order must contain every node exactly once");
+            seen[node] = 1;
+        }
+    }
+
+    // order[position]̐eorder[0..position)IсC̉ƑXRAԂ
+    double search(std::vector<std::size_t> const& order, std::size_t const position, std::vector<std::size_t>& parents)
+    {
+        // ۂߌ덷Őe𑫂Ȃ߁CPʂȉȂ~߂
+        double const epsilon = 1e-9;
+
+        auto const node = order[position];
+        auto score = cache_(node, parents);
+        std::vector<char> chosen(position, 0);
+
+        while(parents.size() < max_parent_num_)
+        {
+            auto best_score = score - epsilon;
+            std::size_t best = position;
+            for(std::size_t k = 0; k < position; ++k)
+            {
+                if(chosen[k]) continue;
+
+                auto candidate = parents;
+                candidate.push_back(order[k]);
+                auto const candidate_score = cache_(node, std::move(candidate));
+                if(candidate_score < best_score)
+                {
+                    best_score = candidate_score;
+                    best = k;
+                }
+            }
+
+            if(best == position) break;
+            chosen[best] = 1;
+            parents.push_back(order[best]);
+            score = best_score;
+        }
+
+        return score;
+    }
+
+    static double write(graph_t& graph, std::vector<std::vector<std::size_t>> const& parents, std::vector<double> const& family)
+    {
+        bitset_graph structure(parents.size());
+        for(std::size_t to = 0; to < parents.size(); ++to)
+        {
+            for(auto const from : parents[to]) structure.add_edge(from, to);
+        }
+        structure.write(graph);
+
+        double result = 0.0;
+        for(auto const score : family) result += score;
+        return result;
+    }
+
+    evaluation::family_score_cache<Score>& cache_;
+    std::size_t max_parent_num_;
+    std::unique_ptr<thread_pool> pool_;
+    engine_type engine_;
+};
+
+} // namespace learning
+} // namespace bn
+
+#endif
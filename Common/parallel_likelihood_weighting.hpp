@@ -0,0 +1,457 @@
+#ifndef COMMON_PARALLEL_LIKELIHOOD_WEIGHTING_HPP
+#define COMMON_PARALLEL_LIKELIHOOD_WEIGHTING_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include <boost/functional/hash.hpp>
+#include <bayesian/graph.hpp>
+#include <bayesian/utility.hpp>
+#include "batch_sampler.hpp"
+#include "compiled_network.hpp"
+#include "parallel_sampling.hpp"
+#include "thread_pool.hpp"
+
+namespace bn {
+namespace inference {
+
+// TvO̒~
+// Evidencechunk_sizeTvǉCSĂ̖₢킹95%MԂ̔half_widthȉ
+// LTv(ESS)min_essȏɂȂ邩CTvmax_sample_numɒB~߂
+struct stopping_rule {
+    double half_width;
+    double min_ess;
+    std::size_t chunk_size;
+    std::size_t max_sample_num;
+};
+
+// ~t̖₢킹̌(evf͖₢킹CESSƃTvEvidence̒l)
+struct query_report {
+    std::vector<double> probability;
+    std::vector<double> half_width;
+    std::vector<double> ess;
+    std::vector<std::size_t> sample_num;
+};
+
+// TvXbhɕčsLikelihood Weighting
+// eXbh͐eGW瓱oƗstd::mt19937߁C
+// V[hƃXbhłΌʂ̓rbgPʂňv
+class parallel_likelihood_weighting {
+public:
+    using engine_type = std::mt19937;
+    using evidence_type = std::unordered_map<vertex_type, std::size_t>;
+    using result_type = std::unordered_map<vertex_type, std::vector<double>>;
+
+    // make_samples̗vf(l̑gnum܂Ƃ߂)
+    struct sample_type {
+        std::vector<std::size_t> select;
+        std::size_t num;
+    };
+
+    using query_type = probability_query;
+
+    explicit parallel_likelihood_weighting(graph_t const& graph, std::size_t const thread_num = 0)
+        : parallel_likelihood_weighting(compiled_network(graph), thread_num)
+    {
+    }
+
+    explicit parallel_likelihood_weighting(compiled_network network, std::size_t const thread_num = 0)
+        : parallel_likelihood_weighting(std::make_shared<compiled_network const>(std::move(network)), thread_num)
+    {
+    }
+
+    // ̐_LbVƋL(network͕ύXȂ)
+    explicit parallel_likelihood_weighting(std::shared_ptr<compiled_network const> network, std::size_t const thread_num = 0)
+        : network_(std::move(network)), thread_num_(thread_num != 0 ? thread_num : thread_pool::default_thread_num()), engine_(make_engine<engine_type>()),
+          pool_(thread_num_ != 1 ? new thread_pool(thread_num_) : nullptr)
+    {
+    }
+
+    // eGW̍ăV[h(ČKvȏꍇ)
+    void seed(engine_type::result_type const value)
+    {
+        engine_.seed(value);
+    }
+
+    std::size_t thread_num() const
+    {
+        return thread_num_;
+    }
+
+    compiled_network const& network() const
+    {
+        return *network_;
+    }
+
+    // evidencẻł̊em[h̎㕪zԂ
+    result_type operator()(evidence_type const& evidence, std::size_t const sample_num)
+    {
+        auto const evidence_value = network_->make_evidence(evidence);
+
+        // eXbhŏdݕtJEg
+        std::vector<std::vector<double>> counts(thread_num_);
+        run(sample_num,
+            [this, &evidence_value, &counts](engine_type& engine, std::size_t const thread, std::size_t const num)
+            {
+                auto& count = counts[thread];
+                count.assign(network_->value_num(), 0.0);
+
+                std::vector<std::uint32_t> value(network_->node_num(), 0);
+                for(std::size_t s = 0; s < num; ++s)
+                {
+                    auto const weight = network_->sample(engine, evidence_value, value.data());
+                    for(std::size_t k = 0; k < value.size(); ++k)
+                        count[network_->value_offset(k) + value[k]] += weight;
+                }
+            });
+
+        // XbhԍɃ}[W(ZŒ肵ČʂIɂ)
+        auto& merged = counts[0];
+        for(std::size_t t = 1; t < thread_num_; ++t)
+        {
+            for(std::size_t i = 0; i < merged.size(); ++i)
+                merged[i] += counts[t][i];
+        }
+
+        // K
+        result_type result;
+        for(std::size_t k = 0; k < network_->node_num(); ++k)
+        {
+            auto const first = merged.begin() + network_->value_offset(k);
+            auto const last = first + network_->arity(k);
+
+            std::vector<double> distribution(first, last);
+            double total = 0.0;
+            for(auto const weight : distribution) total += weight;
+            if(total > 0.0)
+            {
+                for(auto& weight : distribution) weight /= total;
+            }
+            result.insert(std::make_pair(network_->vertex(k), std::move(distribution)));
+        }
+
+        return result;
+    }
+
+    // ̖₢킹܂Ƃ߂ČvZC₢킹̊mԂ
+    // Evidence₢킹͓sample_num̃TvLC
+    // eTvłEvidenceƖ₢킹m[h̑ĉ݂𐶐
+    // EvidenceꕔłقȂ(܊֌W⋤ʕĂ)ʂ̃O[vƂăTvÔŁC
+    // ܂Ƃ߂đȂ͓̂Evidenceɑ΂₢킹ꍇ̂
+    // ₢킹l݂̂𐔂̂ŁCSm[h̎㕪z͍Ȃ
+    std::vector<double> query(std::vector<query_type> const& queries, std::size_t const sample_num)
+    {
+        return query(queries, stopping_rule{0.0, 0.0, sample_num, sample_num}).probability;
+    }
+
+    // ~𖞂܂chunk_sizeTvǉ
+    // 𖞂Evidence͂ȏTvOȂ̂ŁC̑₢킹͑I
+    // dݕtʂ̕U w^2 (I - p)^2 / (w)^2CESS (w)^2 / w^2 Ōς
+    query_report query(std::vector<query_type> const& queries, stopping_rule const& rule)
+    {
+        struct group_type {
+            std::vector<std::size_t> evidence;
+            std::vector<std::uint32_t> active;
+            std::vector<std::size_t> member; // queries̓Y
+        };
+
+        // Evidence(ϑl܂Ŋ܂߂)SɈv̖ɂ܂Ƃ߂(ŏɌꂽ)
+        std::vector<group_type> groups;
+        std::unordered_map<std::vector<std::size_t>, std::size_t, boost::hash<std::vector<std::size_t>>> group_index;
+        std::vector<std::size_t> query_position(queries.size());
+        for(std::size_t i = 0; i < queries.size(); ++i)
+        {
+            auto evidence_value = network_->make_evidence(queries[i].evidence);
+            auto const it = group_index.insert(std::make_pair(evidence_value, groups.size())).first;
+            if(it->second == groups.size())
+                groups.push_back(group_type{std::move(evidence_value), {}, {}});
+
+            groups[it->second].member.push_back(i);
+            query_position[i] = network_->position(queries[i].node);
+        }
+
+        for(auto& group : groups)
+        {
+            std::vector<std::size_t> roots;
+            for(std::size_t k = 0; k < group.evidence.size(); ++k)
+            {
+                if(group.evidence[k] != unobserved) roots.push_back(k);
+            }
+            for(auto const i : group.member) roots.push_back(query_position[i]);
+
+            group.active = network_->ancestors(roots);
+        }
+
+        // d݂̘a(w, w^2)Ɩ₢킹̘a(w I, w^2 I)
+        std::vector<double> total(groups.size(), 0.0), total_square(groups.size(), 0.0);
+        std::vector<double> hit(queries.size(), 0.0), hit_square(queries.size(), 0.0);
+
+        query_report report;
+        report.probability.assign(queries.size(), 0.0);
+        report.half_width.assign(queries.size(), 0.0);
+        report.ess.assign(queries.size(), 0.0);
+        report.sample_num.assign(queries.size(), 0);
+
+        std::vector<std::size_t> running(groups.size());
+        for(std::size_t g = 0; g < groups.size(); ++g) running[g] = g;
+
+        std::size_t sample_num = 0;
+        while(!running.empty() && sample_num < rule.max_sample_num)
+        {
+            auto const chunk = std::min(std::max<std::size_t>(rule.chunk_size, 1), rule.max_sample_num - sample_num);
+            sample_num += chunk;
+
+            // eXbhŏdݕtJEg
+            std::vector<std::vector<double>> sums(thread_num_);
+            run(chunk,
+                [this, &queries, &groups, &query_position, &running, &sums](engine_type& engine, std::size_t const thread, std::size_t const num)
+                {
+                    // [w, w^2]EvidenceɁC[w I, w^2 I]₢킹ɕׂ
+                    auto& sum = sums[thread];
+                    sum.assign(2 * (groups.size() + queries.size()), 0.0);
+                    auto const hit_sum = sum.data() + 2 * groups.size();
+
+                    std::vector<std::uint32_t> value(network_->node_num(), 0);
+                    for(auto const g : running)
+                    {
+                        auto const& group = groups[g];
+                        for(std::size_t s = 0; s < num; ++s)
+                        {
+                            auto const weight = network_->sample(engine, group.evidence, value.data(), group.active);
+                            sum[2 * g] += weight;
+                            sum[2 * g + 1] += weight * weight;
+                            for(auto const i : group.member)
+                            {
+                                if(value[query_position[i]] != queries[i].value) continue;
+                                hit_sum[2 * i] += weight;
+                                hit_sum[2 * i + 1] += weight * weight;
+                            }
+                        }
+                    }
+                });
+
+            // XbhԍɃ}[W
+            for(std::size_t t = 0; t < thread_num_; ++t)
+            {
+                auto const hit_sum = sums[t].data() + 2 * groups.size();
+                for(auto const g : running)
+                {
+                    total[g] += sums[t][2 * g];
+                    total_square[g] += sums[t][2 * g + 1];
+                    for(auto const i : groups[g].member)
+                    {
+                        hit[i] += hit_sum[2 * i];
+                        hit_square[i] += hit_sum[2 * i + 1];
+                    }
+                }
+            }
+
+            // lXVC~𖞂EvidenceO
+            std::vector<std::size_t> next;
+            for(auto const g : running)
+            {
+                auto const ess = total_square[g] > 0.0 ? total[g] * total[g] / total_square[g] : 0.0;
+
+                bool converged = ess >= rule.min_ess && total[g] > 0.0;
+                for(auto const i : groups[g].member)
+                {
+                    auto const p = total[g] > 0.0 ? hit[i] / total[g] : 0.0;
+                    auto const variance = total[g] > 0.0
+                        ? std::max(0.0, hit_square[i] * (1.0 - 2.0 * p) + p * p * total_square[g]) / (total[g] * total[g])
+                        : 0.0;
+
+                    report.probability[i] = p;
+                    report.half_width[i] = 1.96 * std::sqrt(variance);
+                    report.ess[i] = ess;
+                    report.sample_num[i] = sample_num;
+                    if(report.half_width[i] > rule.half_width) converged = false;
+                }
+
+                if(!converged) next.push_back(g);
+            }
+            running = std::move(next);
+        }
+
+        return report;
+    }
+
+    // Tv𐶐(selectvertex_list()̏)
+    // Evidencẽm[h͒lŒ肷݂̂ŁCd݂͍lȂ
+    std::vector<sample_type> make_samples(evidence_type const& evidence, std::size_t const sample_num)
+    {
+        auto const evidence_value = network_->make_evidence(evidence);
+
+        std::vector<table_type> tables(thread_num_);
+        run(sample_num,
+            [this, &evidence_value, &tables](engine_type& engine, std::size_t const thread, std::size_t const num)
+            {
+                std::vector<std::uint32_t> value(network_->node_num(), 0);
+                std::vector<std::size_t> select(network_->node_num(), 0);
+                for(std::size_t s = 0; s < num; ++s)
+                {
+                    network_->sample(engine, evidence_value, value.data());
+                    for(std::size_t k = 0; k < value.size(); ++k)
+                        select[network_->index(k)] = value[k];
+                    ++tables[thread][select];
+                }
+            });
+
+        return merge_samples(tables);
+    }
+
+    // EvidenceȂ̃Tvblock_size܂Ƃ߂Đ(batch_samplergp)
+    // l̑g64bit̐1ɋl߂ꍇ́CubNɐ̃L[PʂōC
+    // בւēg𐔂ĂXbh̕\։(gvectornbVȂ)
+    std::vector<sample_type> make_samples_batch(std::size_t const sample_num, std::size_t const block_size)
+    {
+        // eXbhœƎ~߂Ȃ̂ŁCŒe
+        if(block_size == 0) throw std::runtime_error("error: block_size must be positive");
+
+        std::vector<std::uint64_t> weight;
+        if(make_key_weight(weight))
+        {
+            std::vector<flat_table_type> tables(thread_num_);
+            run(sample_num,
+                [this, &tables, &weight, block_size](engine_type& engine, std::size_t const thread, std::size_t const num)
+                {
+                    batch_sampler sampler(*network_, block_size);
+                    std::vector<std::uint64_t> key(block_size);
+                    for(std::size_t done = 0; done < num; done += block_size)
+                    {
+                        auto const size = std::min(block_size, num - done);
+                        sampler.sample(engine, size);
+
+                        std::fill(key.begin(), key.begin() + size, 0);
+                        for(std::size_t k = 0; k < network_->node_num(); ++k)
+                        {
+                            auto const column = sampler.column(k);
+                            auto const w = weight[network_->index(k)];
+                            for(std::size_t s = 0; s < size; ++s) key[s] += column[s] * w;
+                        }
+
+                        std::sort(key.begin(), key.begin() + size);
+                        for(std::size_t first = 0, last; first < size; first = last)
+                        {
+                            for(last = first + 1; last < size && key[last] == key[first]; ++last);
+                            tables[thread][key[first]] += last - first;
+                        }
+                    }
+                });
+
+            return merge_flat_samples(tables, weight);
+        }
+
+        std::vector<table_type> tables(thread_num_);
+        run(sample_num,
+            [this, &tables, block_size](engine_type& engine, std::size_t const thread, std::size_t const num)
+            {
+                batch_sampler sampler(*network_, block_size);
+                std::vector<std::size_t> select(network_->node_num(), 0);
+                for(std::size_t done = 0; done < num; done += block_size)
+                {
+                    auto const size = std::min(block_size, num - done);
+                    sampler.sample(engine, size);
+                    for(std::size_t s = 0; s < size; ++s)
+                    {
+                        for(std::size_t k = 0; k < select.size(); ++k)
+                            select[network_->index(k)] = sampler.column(k)[s];
+                        ++tables[thread][select];
+                    }
+                }
+            });
+
+        return merge_samples(tables);
+    }
+
+private:
+    using table_type = std::unordered_map<std::vector<std::size_t>, std::size_t, boost::hash<std::vector<std::size_t>>>;
+    using flat_table_type = std::unordered_map<std::uint64_t, std::size_t>;
+
+    // l̑g(vertex_list̏)  l * weight[i] ̐ɋl߂d(̃m[hقǑς)
+    // SĂ̑g64bitɎ܂Ȃfalse
+    bool make_key_weight(std::vector<std::uint64_t>& weight) const
+    {
+        auto const node_num = network_->node_num();
+        std::vector<std::uint64_t> arity(node_num);
+        for(std::size_t k = 0; k < node_num; ++k) arity[network_->index(k)] = network_->arity(k);
+
+        weight.assign(node_num, 0);
+        std::uint64_t step = 1;
+        for(std::size_t i = node_num; i-- > 0;)
+        {
+            weight[i] = step;
+            if(step > std::numeric_limits<std::uint64_t>::max() / arity[i]) return false;
+            step *= arity[i];
+        }
+        return true;
+    }
+
+    // Xbh̏WvXbhԍɃ}[WC̃L[l̑gɖ߂
+    std::vector<sample_type> merge_flat_samples(std::vector<flat_table_type>& tables, std::vector<std::uint64_t> const& weight) const
+    {
+        auto& merged = tables[0];
+        for(std::size_t t = 1; t < tables.size(); ++t)
+        {
+            for(auto const& elem : tables[t])
+                merged[elem.first] += elem.second;
+        }
+
+        std::vector<sample_type> samples;
+        samples.reserve(merged.size());
+        for(auto const& elem : merged)
+        {
+            std::vector<std::size_t> select(weight.size());
+            auto rest = elem.first;
+            for(std::size_t i = 0; i < weight.size(); ++i)
+            {
+                select[i] = static_cast<std::size_t>(rest / weight[i]);
+                rest %= weight[i];
+            }
+            samples.push_back(sample_type{std::move(select), elem.second});
+        }
+
+        return samples;
+    }
+
+
+    // sample_numXbhɊUfunc(engine, thread, num)s
+    template<class Func>
+    void run(std::size_t const sample_num, Func func)
+    {
+        parallel_sampling(engine_, pool_.get(), thread_num_, sample_num, func);
+    }
+
+    // Xbh̏WvXbhԍɃ}[W
+    std::vector<sample_type> merge_samples(std::vector<table_type>& tables) const
+    {
+        auto& merged = tables[0];
+        for(std::size_t t = 1; t < tables.size(); ++t)
+        {
+            for(auto const& elem : tables[t])
+                merged[elem.first] += elem.second;
+        }
+
+        std::vector<sample_type> samples;
+        samples.reserve(merged.size());
+        for(auto const& elem : merged)
+            samples.push_back(sample_type{elem.first, elem.second});
+
+        return samples;
+    }
+
+    std::shared_ptr<compiled_network const> network_;
+    std::size_t thread_num_;
+    engine_type engine_;
+    std::unique_ptr<thread_pool> pool_;
+};
+
+} // namespace inference
+} // namespace bn
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef COMMON_PARALLEL_SAMPLING_HPP
+#define COMMON_PARALLEL_SAMPLING_HPP
+
+#include <exception>
+#include <random>
+#include <vector>
+#include "thread_pool.hpp"
+
+namespace bn {
+namespace inference {
+
+// sample_numthread_numɊUfunc(engine, thread, num)poolŎs
+// ẽGW͌ďomasteroV[hƕ̔ԍ̂ŁC
+// master̃V[hthread_numłΌʂ̓rbgPʂňv(pool̑傫ɂ͈˂Ȃ)
+// poolnullptrȂďõXbhŏɎs
+// func̗O͑SĂ̕IɌďo֍đo
+template<class Engine, class Func>
+void parallel_sampling(Engine& master, thread_pool* const pool, std::size_t const thread_num, std::size_t const sample_num, Func func)
+{
+    std::vector<typename Engine::result_type> seeds(thread_num);
+    for(auto& seed : seeds) seed = master();
+
+    auto const task = [&func, &seeds, thread_num, sample_num](std::size_t const t)
+    {
+        std::size_t const num = sample_num / thread_num + (t < sample_num % thread_num ? 1 : 0);
+        std::seed_seq seq{seeds[t], static_cast<typename Engine::result_type>(t)};
+        Engine engine(seq);
+        func(engine, t, num);
+    };
+
+    if(!pool)
+    {
+        for(std::size_t t = 0; t < thread_num; ++t) task(t);
+        return;
+    }
+
+    try
+    {
+        for(std::size_t t = 0; t < thread_num; ++t)
+            pool->submit([&task, t]{ task(t); });
+    }
+    catch(...)
+    {
+        // o^ς݂̃^XNseedsfuncQƂĂ̂ŁCI܂ő҂Ă甲
+        try { pool->wait(); } catch(...) {}
+        throw;
+    }
+    pool->wait();
+}
+
+} // namespace inference
+} // namespace bn
+
+#endif
@@ -0,0 +1,235 @@
+#ifndef COMMON_PARALLEL_TEMPERING_HPP
+#define COMMON_PARALLEL_TEMPERING_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <bayesian/graph.hpp>
+#include <bayesian/utility.hpp>
+#include "bitset_graph.hpp"
+#include "family_score.hpp"
+#include "reachability_index.hpp"
+#include "thread_pool.hpp"
+
+namespace bn {
+namespace learning {
+
+// eJ@̐ݒ
+// chain_num{(0ȂXbh)̍min_temperaturemax_temperature܂ł̉x𓙔Ɋ蓖āC
+// esweep_num񂸂Ă閈ɗׂ荇x̍̊ԂŏԂ݂̌(round_numJԂ)
+struct tempering_schedule {
+    std::size_t chain_num;
+    double min_temperature;
+    double max_temperature;
+    std::size_t sweep_num;
+    std::size_t round_num;
+};
+
+// ƑXRÃLbVLeJ@(ẍقȂĂȂ܂̍ɉ)
+// e͕ӂ̒ǉE폜E]_ɒĂCMetropolisŎ󗝂
+// XRA͏قǗǂCSĂ̍ʂčłǂ\Ԃ
+// ̃GW͌ďoɐeGW瓱oC͑SĂ̍~܂Ă獽̏ɍŝŁC
+// V[hchain_numłΌʂ̓XbhɈ˂Ȃ
+// thread_num1ȂXbhv[炸CĂ񂾃Xbhōɉ
+template<class Score>
+class parallel_tempering {
+public:
+    using engine_type = std::mt19937;
+
+    explicit parallel_tempering(evaluation::family_score_cache<Score>& cache, std::size_t const thread_num = 0)
+        : cache_(cache), pool_(thread_num != 1 ? new thread_pool(thread_num) : nullptr), engine_(make_engine<engine_type>())
+    {
+    }
+
+    void seed(engine_type::result_type const value)
+    {
+        engine_.seed(value);
+    }
+
+    // graph̕ӂSĂ̍̏ƂCŗǂ̍\graphɏ߂ăXRAԂ
+    double operator()(graph_t& graph, tempering_schedule const& schedule)
+    {
+        auto const chain_num = schedule.chain_num != 0 ? schedule.chain_num : (pool_ ? pool_->size() : 1);
+        if(!(schedule.min_temperature > 0.0) || schedule.max_temperature < schedule.min_temperature)
+            throw std::runtime_error("error: Invalid tempering schedule");
+
+        std::vector<double> temperature(chain_num);
+        for(std::size_t k = 0; k < chain_num; ++k)
+        {
+            temperature[k] = chain_num == 1
+                ? schedule.min_temperature
+                : schedule.min_temperature * std::pow(schedule.max_temperature / schedule.min_temperature, k / (chain_num - 1.0));
+        }
+
+        state initial;
+        initial.structure = bitset_graph(graph);
+        initial.reachability.reset(initial.structure.node_num());
+        initial.score = 0.0;
+        for(std::size_t to = 0; to < initial.structure.node_num(); ++to)
+        {
+            for(auto const from : initial.structure.parents(to)) initial.reachability.add_edge(from, to);
+            initial.family.push_back(cache_(to, initial.structure.parents(to)));
+            initial.score += initial.family.back();
+        }
+
+        std::vector<chain> chains(chain_num);
+        for(std::size_t k = 0; k < chain_num; ++k)
+        {
+            std::seed_seq seq{engine_(), static_cast<engine_type::result_type>(k)};
+            chains[k].engine.seed(seq);
+            chains[k].current = initial;
+            chains[k].best_score = initial.score;
+            chains[k].best = initial.structure;
+        }
+
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        for(std::size_t round = 0; round < schedule.round_num; ++round)
+        {
+            if(pool_)
+            {
+                for(std::size_t k = 0; k < chain_num; ++k)
+                {
+                    pool_->submit([this, &chains, &temperature, &schedule, k]
+                    {
+                        anneal(chains[k], temperature[k], schedule.sweep_num);
+                    });
+                }
+                pool_->wait();
+            }
+            else
+            {
+                for(std::size_t k = 0; k < chain_num; ++k)
+                    anneal(chains[k], temperature[k], schedule.sweep_num);
+            }
+
+            // ׂ荇̌(Ԗڂ̑gƊԖڂ̑g݂Ɏ)
+            for(auto k = round % 2; k + 1 < chain_num; k += 2)
+            {
+                auto const log_ratio = (chains[k].current.score - chains[k + 1].current.score)
+                    * (1.0 / temperature[k] - 1.0 / temperature[k + 1]);
+                if(log_ratio >= 0.0 || uniform(engine_) < std::exp(log_ratio))
+                    std::swap(chains[k].current, chains[k + 1].current);
+            }
+        }
+
+        // ̏ɔׂ(XRAȂ̍)
+        std::size_t best = 0;
+        for(std::size_t k = 1; k < chain_num; ++k)
+        {
+            if(chains[k].best_score < chains[best].best_score) best = k;
+        }
+
+        chains[best].best.write(graph);
+        return cache_(chains[best].best);
+    }
+
+private:
+    struct state {
+        bitset_graph structure;
+        reachability_index reachability;
+        std::vector<double> family;
+        double score;
+    };
+
+    struct chain {
+        engine_type engine;
+        state current;
+        double best_score;
+        bitset_graph best;
+    };
+
+    // xtemperaturesweep_num̎Ă
+    void anneal(chain& target, double const temperature, std::size_t const sweep_num)
+    {
+        auto& current = target.current;
+        auto const node_num = current.structure.node_num();
+        if(node_num < 2) return;
+
+        std::uniform_int_distribution<std::size_t> pick(0, node_num - 1);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        for(std::size_t i = 0; i < sweep_num; ++i)
+        {
+            auto from = pick(target.engine);
+            auto to = pick(target.engine);
+            if(from == to) continue;
+
+            // ɂӂfromtǒɑ
+            if(current.structure.has_edge(to, from)) std::swap(from, to);
+
+            double delta, to_score, from_score = 0.0;
+            bool const exists = current.structure.has_edge(from, to);
+            bool const reverse = exists && uniform(target.engine) < 0.5;
+            if(reverse)
+            {
+                if(current.reachability.reverse_makes_cycle(from, to)) continue;
+                to_score = cache_(to, without(current.structure.parents(to), from));
+                from_score = cache_(from, with(current.structure.parents(from), to));
+                delta = to_score - current.family[to] + from_score - current.family[from];
+            }
+            else if(exists)
+            {
+                to_score = cache_(to, without(current.structure.parents(to), from));
+                delta = to_score - current.family[to];
+            }
+            else
+            {
+                if(current.reachability.makes_cycle(from, to)) continue;
+                to_score = cache_(to, with(current.structure.parents(to), from));
+                delta = to_score - current.family[to];
+            }
+
+            if(delta > 0.0 && uniform(target.engine) >= std::exp(-delta / temperature)) continue;
+
+            if(exists)
+            {
+                current.structure.erase_edge(from, to);
+                current.reachability.erase_edge(from, to);
+            }
+            if(reverse)
+            {
+                current.structure.add_edge(to, from);
+                current.reachability.add_edge(to, from);
+                current.family[from] = from_score;
+            }
+            else if(!exists)
+            {
+                current.structure.add_edge(from, to);
+                current.reachability.add_edge(from, to);
+            }
+            current.family[to] = to_score;
+            current.score += delta;
+
+            if(current.score < target.best_score)
+            {
+                target.best_score = current.score;
+                target.best = current.structure;
+            }
+        }
+    }
+
+    static std::vector<std::size_t> with(std::vector<std::size_t> list, std::size_t const value)
+    {
+        list.push_back(value);
+        return list;
+    }
+
+    static std::vector<std::size_t> without(std::vector<std::size_t> list, std::size_t const value)
+    {
+        list.erase(std::find(list.begin(), list.end(), value));
+        return list;
+    }
+
+    evaluation::family_score_cache<Score>& cache_;
+    std::unique_ptr<thread_pool> pool_;
+    engine_type engine_;
+};
+
+} // namespace learning
+} // namespace bn
+
+#endif
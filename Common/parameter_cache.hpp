@@ -0,0 +1,138 @@
+#ifndef COMMON_PARAMETER_CACHE_HPP
+#define COMMON_PARAMETER_CACHE_HPP
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <boost/functional/hash.hpp>
+#include <bayesian/graph.hpp>
+#include "column_counter.hpp"
+#include "compiled_network.hpp"
+
+namespace bn {
+
+// Ot̍\ɃTv琄肵p[^(compiled_network)ێ
+// _CPT(sampler::make_cpt)gȂ̂ŁC_L鑽̃Ot
+// Xbh瓯ɈĂ悢
+// \(em[h̐eW)̃Otɂ͓IuWFNgԂ
+// x͉Ƒ(q, eW)ɂێ̂ŁCõOtӂ𐔖{ςOtł
+// eW̕ςm[ĥ݂𐔂
+// (sampler::make_cptƂ͖o̐e̒l̑g̈Ⴂ̂ŁCMAECalculatorł--fast-cptw莞̂ݎg)
+template<class Counter>
+class parameter_cache {
+public:
+    using parameter_type = std::shared_ptr<compiled_network const>;
+
+    explicit parameter_cache(Counter const& counter)
+        : family_(counter)
+    {
+    }
+
+    parameter_cache(parameter_cache const&) = delete;
+    parameter_cache& operator=(parameter_cache const&) = delete;
+
+    parameter_type operator()(graph_t const& graph)
+    {
+        auto key = make_key(graph);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto const it = table_.find(key);
+            if(it != table_.end()) return it->second;
+        }
+
+        // ̓bN̊Oōs(ɍꂽꍇ͐ɓo^ꂽԂ)
+        auto parameter = std::make_shared<compiled_network const>(graph, family_);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        return table_.insert(std::make_pair(std::move(key), std::move(parameter))).first->second;
+    }
+
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return table_.size();
+    }
+
+    // ۂɐƑ̐
+    std::size_t family_size() const
+    {
+        return family_.size();
+    }
+
+private:
+    using key_type = std::vector<std::size_t>;
+
+    // Ƒ̓xoĂCounter
+    // compiled_network͐eԍɕׂĖ₢킹̂ŁC(q, e̗)̂܂܃L[ɂ
+    class family_counter {
+    public:
+        explicit family_counter(Counter const& counter)
+            : counter_(counter)
+        {
+        }
+
+        count_cells count(std::size_t const child, std::vector<std::size_t> const& parents) const
+        {
+            key_type key;
+            key.reserve(parents.size() + 1);
+            key.push_back(child);
+            key.insert(key.end(), parents.begin(), parents.end());
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto const it = table_.find(key);
+                if(it != table_.end()) return it->second;
+            }
+
+            auto cells = counter_.count(child, parents);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            return table_.insert(std::make_pair(std::move(key), std::move(cells))).first->second;
+        }
+
+        std::size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return table_.size();
+        }
+
+    private:
+        Counter const& counter_;
+
+        mutable std::mutex mutex_;
+        mutable std::unordered_map<key_type, count_cells, boost::hash<key_type>> table_;
+    };
+
+    // em[h̃\[gς݂̐e̔ԍCe̐؂Ƃĕׂ
+    static key_type make_key(graph_t const& graph)
+    {
+        auto const& nodes = graph.vertex_list();
+        std::unordered_map<vertex_type, std::size_t> index;
+        for(std::size_t i = 0; i < nodes.size(); ++i) index[nodes[i]] = i;
+
+        key_type key;
+        for(auto const& node : nodes)
+        {
+            std::vector<std::size_t> parents;
+            for(auto const& edge : graph.in_edges(node))
+                parents.push_back(index.at(graph.source(edge)));
+            std::sort(parents.begin(), parents.end());
+
+            key.push_back(parents.size());
+            key.insert(key.end(), parents.begin(), parents.end());
+        }
+
+        return key;
+    }
+
+    family_counter family_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<key_type, parameter_type, boost::hash<key_type>> table_;
+};
+
+} // namespace bn
+
+#endif
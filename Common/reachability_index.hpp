@@ -0,0 +1,153 @@
+#ifndef COMMON_REACHABILITY_INDEX_HPP
+#define COMMON_REACHABILITY_INDEX_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace bn {
+
+// L񏄉Ot̓B\̍(_0..node_num-1̔ԍň)
+// _ɁuH蒅钸_ṽrbg̂ŁCH肪DFSO(1)ōς
+// ӂ̒ǉłfrom̑c̍sto̍s𑫂Cӂ̍폜łfrom̑c̍sqgݒ
+class reachability_index {
+public:
+    explicit reachability_index(std::size_t const node_num = 0)
+    {
+        reset(node_num);
+    }
+
+    // ӂ̖node_num_̃Otɂ
+    void reset(std::size_t const node_num)
+    {
+        node_num_ = node_num;
+        words_ = (node_num + 63) / 64;
+        rows_.assign(node_num * words_, 0);
+        children_.assign(node_num, std::vector<std::size_t>());
+    }
+
+    std::size_t node_num() const
+    {
+        return node_num_;
+    }
+
+    std::vector<std::size_t> const& children(std::size_t const node) const
+    {
+        return children_[node];
+    }
+
+    // from1{ȏ̕ӂHto֒邩
+    bool reachable(std::size_t const from, std::size_t const to) const
+    {
+        return test(from, to);
+    }
+
+    // fromto̕ӂǉƕHɂȂ邩
+    bool makes_cycle(std::size_t const from, std::size_t const to) const
+    {
+        return from == to || test(to, from);
+    }
+
+    // fromto̕ӂ𔽓]ƕHɂȂ邩(fromtoȊǑoHto֒邩)
+    bool reverse_makes_cycle(std::size_t const from, std::size_t const to) const
+    {
+        for(auto const child : children_[from])
+        {
+            if(child != to && test(child, to)) return true;
+        }
+        return false;
+    }
+
+    // HȂƂ͌ĂяoŊm߂邱
+    void add_edge(std::size_t const from, std::size_t const to)
+    {
+        children_[from].push_back(to);
+
+        // fromƂ̑ćCtoto̎q֒
+        auto const source = row(to);
+        for(std::size_t node = 0; node < node_num_; ++node)
+        {
+            if(node != from && !test(node, from)) continue;
+
+            auto const target = row(node);
+            for(std::size_t w = 0; w < words_; ++w) target[w] |= source[w];
+            set(node, to);
+        }
+    }
+
+    void erase_edge(std::size_t const from, std::size_t const to)
+    {
+        children_[from].erase(std::find(children_[from].begin(), children_[from].end(), to));
+
+        // ς蓾̂fromƂ̑c̍sȂ̂ŁCqɂȂ鏇ɑgݒ
+        std::vector<char> affected(node_num_, 0);
+        for(std::size_t node = 0; node < node_num_; ++node)
+            affected[node] = node == from || test(node, from);
+
+        std::vector<char> done(node_num_, 0);
+        for(std::size_t node = 0; node < node_num_; ++node)
+        {
+            if(affected[node] && !done[node]) rebuild(node, affected, done);
+        }
+    }
+
+private:
+    std::uint64_t* row(std::size_t const node)
+    {
+        return rows_.data() + node * words_;
+    }
+
+    bool test(std::size_t const from, std::size_t const to) const
+    {
+        return (rows_[from * words_ + to / 64] >> (to % 64)) & 1;
+    }
+
+    void set(std::size_t const from, std::size_t const to)
+    {
+        rows_[from * words_ + to / 64] |= std::uint64_t(1) << (to % 64);
+    }
+
+    // e󂯂钸_q珇ɑgݒ(A肪̔DFS)
+    void rebuild(std::size_t const start, std::vector<char> const& affected, std::vector<char>& done)
+    {
+        std::vector<std::pair<std::size_t, std::size_t>> stack(1, std::make_pair(start, std::size_t(0)));
+        done[start] = 1;
+
+        while(!stack.empty())
+        {
+            auto const node = stack.back().first;
+            auto& next = stack.back().second;
+
+            if(next < children_[node].size())
+            {
+                auto const child = children_[node][next++];
+                if(affected[child] && !done[child])
+                {
+                    done[child] = 1;
+                    stack.push_back(std::make_pair(child, std::size_t(0)));
+                }
+                continue;
+            }
+
+            auto const target = row(node);
+            std::fill(target, target + words_, 0);
+            for(auto const child : children_[node])
+            {
+                auto const source = row(child);
+                for(std::size_t w = 0; w < words_; ++w) target[w] |= source[w];
+                set(node, child);
+            }
+            stack.pop_back();
+        }
+    }
+
+    std::size_t node_num_;
+    std::size_t words_;
+    std::vector<std::uint64_t> rows_;
+    std::vector<std::vector<std::size_t>> children_;
+};
+
+} // namespace bn
+
+#endif
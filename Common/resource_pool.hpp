@@ -0,0 +1,98 @@
+#ifndef COMMON_RESOURCE_POOL_HPP
+#define COMMON_RESOURCE_POOL_HPP
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace bn {
+
+// XbhԂŋLłȂdIuWFNg(bn::samplerȂ)݂o
+// acquireŋ󂢂Ă̂1؂Clease̔jŕԂ
+// 󂫂Ȃfactoryō̂ŁC鐔͓Ɏ؂Xbh𒴂Ȃ
+template<class T>
+class resource_pool {
+public:
+    class lease {
+    public:
+        lease(resource_pool& pool, std::unique_ptr<T> resource)
+            : pool_(&pool), resource_(std::move(resource))
+        {
+        }
+
+        lease(lease&& other)
+            : pool_(other.pool_), resource_(std::move(other.resource_))
+        {
+        }
+
+        ~lease()
+        {
+            if(resource_) pool_->release(std::move(resource_));
+        }
+
+        lease(lease const&) = delete;
+        lease& operator=(lease const&) = delete;
+        lease& operator=(lease&&) = delete;
+
+        T& operator*() const
+        {
+            return *resource_;
+        }
+
+        T* operator->() const
+        {
+            return resource_.get();
+        }
+
+    private:
+        resource_pool* pool_;
+        std::unique_ptr<T> resource_;
+    };
+
+    explicit resource_pool(std::function<std::unique_ptr<T>()> factory)
+        : factory_(std::move(factory))
+    {
+    }
+
+    resource_pool(resource_pool const&) = delete;
+    resource_pool& operator=(resource_pool const&) = delete;
+
+    lease acquire()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(!idle_.empty())
+            {
+                auto resource = std::move(idle_.back());
+                idle_.pop_back();
+                return lease(*this, std::move(resource));
+            }
+        }
+
+        // ͎̂Ԃ̂ŃbN̊Oōs
+        return lease(*this, factory_());
+    }
+
+    // ܂łɍāC݂͑oĂȂ̂̐
+    std::size_t idle_num() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return idle_.size();
+    }
+
+private:
+    void release(std::unique_ptr<T> resource)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_.push_back(std::move(resource));
+    }
+
+    std::function<std::unique_ptr<T>()> const factory_;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<T>> idle_;
+};
+
+} // namespace bn
+
+#endif
@@ -0,0 +1,460 @@
+#ifndef COMMON_SAMPLE_TABLE_HPP
+#define COMMON_SAMPLE_TABLE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <bayesian/graph.hpp>
+#include "mapped_file.hpp"
+
+namespace bn {
+
+// oCi`̃Tvt@C
+//   header : magic "BNSB", version, node_num, row_num, block_num, arity[node_num], width[node_num]
+//   block  : row_num, count_width, count̗, em[h̒l̗
+// larityɉ1/2/4byteCcount͊eubN̍őlɉ1/2/4/8byteɋl߂
+// e8byteEɑ邽߁Cmmap܂ܒړǂݏo(GfBA͏ovZ@Ɉˑ)
+namespace binary_sample {
+
+char const magic[4] = {'B', 'N', 'S', 'B'};
+std::uint32_t const version = 1;
+
+// 擪magicŃoCi`̃t@Cǂ𔻒肷
+inline bool is_binary_file(std::string const& path)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    char head[sizeof(magic)];
+    return ifs.read(head, sizeof(head)) && std::memcmp(head, magic, sizeof(magic)) == 0;
+}
+
+inline std::size_t padding(std::size_t const size)
+{
+    return (8 - size % 8) % 8;
+}
+
+inline std::uint8_t value_width(std::size_t const arity)
+{
+    if(arity <= 0x100)   return 1;
+    if(arity <= 0x10000) return 2;
+    return 4;
+}
+
+inline std::uint8_t count_width(std::uint64_t const max_count)
+{
+    if(max_count <= 0xFF)       return 1;
+    if(max_count <= 0xFFFF)     return 2;
+    if(max_count <= 0xFFFFFFFF) return 4;
+    return 8;
+}
+
+inline std::uint64_t read(unsigned char const* data, std::size_t const width, std::size_t const index)
+{
+    switch(width)
+    {
+    case 1: return data[index];
+    case 2: { std::uint16_t v; std::memcpy(&v, data + index * 2, 2); return v; }
+    case 4: { std::uint32_t v; std::memcpy(&v, data + index * 4, 4); return v; }
+    default:{ std::uint64_t v; std::memcpy(&v, data + index * 8, 8); return v; }
+    }
+}
+
+// 1܂Ƃ߂ēWJCWJl̍őlԂ(l͈̔͂̊mFɎg)
+template<class T>
+std::uint64_t decode(unsigned char const* data, std::size_t const width, std::size_t const size, T* output)
+{
+    std::uint64_t max_value = 0;
+    switch(width)
+    {
+    case 1:
+        for(std::size_t i = 0; i < size; ++i) { auto const v = data[i]; output[i] = static_cast<T>(v); max_value = std::max<std::uint64_t>(max_value, v); }
+        break;
+    case 2:
+        for(std::size_t i = 0; i < size; ++i) { std::uint16_t v; std::memcpy(&v, data + i * 2, 2); output[i] = static_cast<T>(v); max_value = std::max<std::uint64_t>(max_value, v); }
+        break;
+    case 4:
+        for(std::size_t i = 0; i < size; ++i) { std::uint32_t v; std::memcpy(&v, data + i * 4, 4); output[i] = static_cast<T>(v); max_value = std::max<std::uint64_t>(max_value, v); }
+        break;
+    default:
+        for(std::size_t i = 0; i < size; ++i) { std::uint64_t v; std::memcpy(&v, data + i * 8, 8); output[i] = static_cast<T>(v); max_value = std::max(max_value, v); }
+        break;
+    }
+    return max_value;
+}
+
+// oCi`̏o
+// write_blockxĂł悭CcloseŃwb_̍sEubNm肳
+class writer {
+public:
+    writer(std::string const& path, std::vector<vertex_type> const& nodes)
+        : ofs_(path, std::ios::binary), row_num_(0), block_num_(0)
+    {
+        if(!ofs_) throw std::runtime_error("error: Cannot open " + path);
+
+        for(auto const& node : nodes)
+        {
+            arity_.push_back(static_cast<std::uint32_t>(node->selectable_num));
+            width_.push_back(value_width(node->selectable_num));
+        }
+
+        std::uint64_t const node_num = nodes.size();
+        ofs_.write(magic, sizeof(magic));
+        write_pod(version);
+        write_pod(node_num);
+        row_position_ = ofs_.tellp();
+        write_pod(row_num_);
+        write_pod(block_num_);
+        ofs_.write(reinterpret_cast<char const*>(arity_.data()), arity_.size() * sizeof(std::uint32_t));
+        ofs_.write(reinterpret_cast<char const*>(width_.data()), width_.size());
+        write_padding(arity_.size() * sizeof(std::uint32_t) + width_.size());
+    }
+
+    ~writer()
+    {
+        if(ofs_.is_open()) close();
+    }
+
+    // .select(vertex_list()̏).numvf̗1ubNƂďo
+    template<class Samples>
+    void write_block(Samples const& samples)
+    {
+        std::uint64_t const rows = samples.size();
+        if(rows == 0) return;
+
+        std::uint64_t max_count = 0;
+        for(auto const& sample : samples) max_count = std::max<std::uint64_t>(max_count, sample.num);
+        std::uint8_t const count_size = count_width(max_count);
+
+        write_pod(rows);
+        write_pod(static_cast<std::uint64_t>(count_size));
+
+        buffer_.resize(rows * 8);
+        for(std::size_t r = 0; r < rows; ++r)
+            put(count_size, r, samples[r].num);
+        write_column(rows * count_size);
+
+        for(std::size_t k = 0; k < arity_.size(); ++k)
+        {
+            for(std::size_t r = 0; r < rows; ++r)
+                put(width_[k], r, samples[r].select[k]);
+            write_column(rows * width_[k]);
+        }
+
+        row_num_ += rows;
+        ++block_num_;
+    }
+
+    void close()
+    {
+        ofs_.seekp(row_position_);
+        write_pod(row_num_);
+        write_pod(block_num_);
+        ofs_.close();
+    }
+
+private:
+    template<class T>
+    void write_pod(T const& value)
+    {
+        ofs_.write(reinterpret_cast<char const*>(&value), sizeof(T));
+    }
+
+    void write_padding(std::size_t const size)
+    {
+        char const zero[8] = {};
+        ofs_.write(zero, padding(size));
+    }
+
+    void put(std::size_t const width, std::size_t const index, std::uint64_t const value)
+    {
+        switch(width)
+        {
+        case 1: buffer_[index] = static_cast<unsigned char>(value); break;
+        case 2: { auto const v = static_cast<std::uint16_t>(value); std::memcpy(&buffer_[index * 2], &v, 2); break; }
+        case 4: { auto const v = static_cast<std::uint32_t>(value); std::memcpy(&buffer_[index * 4], &v, 4); break; }
+        default:{ auto const v = static_cast<std::uint64_t>(value); std::memcpy(&buffer_[index * 8], &v, 8); break; }
+        }
+    }
+
+    void write_column(std::size_t const size)
+    {
+        ofs_.write(reinterpret_cast<char const*>(buffer_.data()), size);
+        write_padding(size);
+    }
+
+    std::ofstream ofs_;
+    std::streampos row_position_;
+    std::uint64_t row_num_;
+    std::uint64_t block_num_;
+    std::vector<std::uint32_t> arity_;
+    std::vector<std::uint8_t> width_;
+    std::vector<unsigned char> buffer_;
+};
+
+} // namespace binary_sample
+
+// Tvt@C(eLXg` "num v0 v1 ..." ƃoCi`̗)wŕێ
+// oCi`mmap܂܁CeLXg`͓ǂݍ1ubNƂĕێ
+class sample_table {
+public:
+    struct block_type {
+        std::size_t row_num;
+        std::size_t count_width;
+        unsigned char const* count;
+        std::vector<unsigned char const*> column;
+    };
+
+    sample_table()
+        : row_num_(0), sampling_size_(0)
+    {
+    }
+
+    // ubN͎g̎obt@w߃Rs[͋֎~
+    sample_table(sample_table const&) = delete;
+    sample_table& operator=(sample_table const&) = delete;
+
+    // t@C`͐擪magicŔ肷
+    void load(std::string const& path, std::vector<vertex_type> const& nodes)
+    {
+        clear();
+        for(auto const& node : nodes) arity_.push_back(node->selectable_num);
+
+        file_.reset(new mapped_file(path));
+        auto const data = reinterpret_cast<unsigned char const*>(file_->begin());
+        auto const size = file_->size();
+        if(size == 0) return;
+
+        if(size >= sizeof(binary_sample::magic) && std::memcmp(data, binary_sample::magic, sizeof(binary_sample::magic)) == 0)
+        {
+            load_binary(data, size);
+        }
+        else
+        {
+            load_text(file_->begin(), size);
+            file_.reset();
+        }
+    }
+
+    std::size_t node_num() const
+    {
+        return arity_.size();
+    }
+
+    // قȂl̑g(s)̐
+    std::size_t row_num() const
+    {
+        return row_num_;
+    }
+
+    // count܂߂STv
+    std::uint64_t sampling_size() const
+    {
+        return sampling_size_;
+    }
+
+    std::size_t arity(std::size_t const node) const
+    {
+        return arity_[node];
+    }
+
+    std::size_t block_num() const
+    {
+        return block_.size();
+    }
+
+    block_type const& block(std::size_t const index) const
+    {
+        return block_[index];
+    }
+
+    std::uint64_t count(std::size_t const block_index, std::size_t const row) const
+    {
+        auto const& b = block_[block_index];
+        return binary_sample::read(b.count, b.count_width, row);
+    }
+
+    std::uint32_t value(std::size_t const block_index, std::size_t const node, std::size_t const row) const
+    {
+        auto const& b = block_[block_index];
+        auto const v = binary_sample::read(b.column[node], width_[node], row);
+        if(v >= arity_[node]) throw std::runtime_error("error: Broken binary sample file (value out of range)");
+        return static_cast<std::uint32_t>(v);
+    }
+
+    // ubN1܂Ƃ߂ēWJ
+    // l͓x\̓YɂȂ̂ŁCarity͈̔͂ɂ邱ƂWĴłɊm߂
+    // (ǂݍݎɑS𑖍mmap̈Ӗ邽߁Cg񂾂Ŋm߂)
+    template<class T>
+    void decode_column(std::size_t const block_index, std::size_t const node, T* output) const
+    {
+        auto const& b = block_[block_index];
+        if(b.row_num != 0 && binary_sample::decode(b.column[node], width_[node], b.row_num, output) >= arity_[node])
+            throw std::runtime_error("error: Broken binary sample file (value out of range)");
+    }
+
+    template<class T>
+    void decode_count(std::size_t const block_index, T* output) const
+    {
+        auto const& b = block_[block_index];
+        binary_sample::decode(b.count, b.count_width, b.row_num, output);
+    }
+
+private:
+    void clear()
+    {
+        arity_.clear();
+        width_.clear();
+        block_.clear();
+        owned_count_.clear();
+        owned_value_.clear();
+        row_num_ = 0;
+        sampling_size_ = 0;
+        file_.reset();
+    }
+
+    void load_binary(unsigned char const* data, std::size_t const size)
+    {
+        std::size_t offset = sizeof(binary_sample::magic);
+        auto const take = [&](std::size_t const length) -> unsigned char const*
+        {
+            if(length > size - offset) throw std::runtime_error("error: Broken binary sample file");
+            auto const result = data + offset;
+            offset += length;
+            return result;
+        };
+        auto const take_u64 = [&]() -> std::uint64_t
+        {
+            std::uint64_t v;
+            std::memcpy(&v, take(8), 8);
+            return v;
+        };
+        // num~width byte̗Ƃ̃pfBO(|ZȂ悤Ɏc̑傫Ɣׂ)
+        auto const take_column = [&](std::uint64_t const num, std::size_t const width) -> unsigned char const*
+        {
+            if(num > (size - offset) / width) throw std::runtime_error("error: Broken binary sample file");
+            auto const length = static_cast<std::size_t>(num) * width;
+            auto const result = take(length);
+            take(binary_sample::padding(length));
+            return result;
+        };
+
+        std::uint32_t version;
+        std::memcpy(&version, take(4), 4);
+        if(version != binary_sample::version) throw std::runtime_error("error: Unsupported binary sample version");
+
+        auto const node_num = take_u64();
+        auto const row_num = take_u64();
+        auto const block_num = take_u64();
+        if(node_num != arity_.size()) throw std::runtime_error("error: Node num of the sample file does not match the graph");
+        if(row_num > std::numeric_limits<std::size_t>::max()) throw std::runtime_error("error: Broken binary sample file (row num)");
+        row_num_ = static_cast<std::size_t>(row_num);
+
+        // node_num̓Ot̒_ƈvĂ̂ŁCł̊|Z͈Ȃ
+        auto const arity = take(node_num * sizeof(std::uint32_t));
+        auto const width = take(node_num);
+        take(binary_sample::padding(node_num * sizeof(std::uint32_t) + node_num));
+        for(std::size_t k = 0; k < node_num; ++k)
+        {
+            std::uint32_t a;
+            std::memcpy(&a, arity + k * sizeof(std::uint32_t), sizeof(std::uint32_t));
+            if(a != arity_[k]) throw std::runtime_error("error: Arity of the sample file does not match the graph");
+            if(width[k] != 1 && width[k] != 2 && width[k] != 4) throw std::runtime_error("error: Broken binary sample file (value width)");
+            width_.push_back(width[k]);
+        }
+
+        std::uint64_t total_row_num = 0;
+
+        for(std::uint64_t b = 0; b < block_num; ++b)
+        {
+            block_type block;
+            auto const block_row_num = take_u64();
+            auto const count_width = take_u64();
+            if(count_width != 1 && count_width != 2 && count_width != 4 && count_width != 8)
+                throw std::runtime_error("error: Broken binary sample file (count width)");
+            block.count_width = static_cast<std::size_t>(count_width);
+            block.count = take_column(block_row_num, block.count_width);
+            block.row_num = static_cast<std::size_t>(block_row_num);
+            // l͈̔͂decode_column/valueŊm߂
+            for(std::size_t k = 0; k < node_num; ++k)
+                block.column.push_back(take_column(block_row_num, width_[k]));
+
+            for(std::size_t r = 0; r < block.row_num; ++r)
+                sampling_size_ += binary_sample::read(block.count, block.count_width, r);
+            total_row_num += block.row_num;
+            block_.push_back(std::move(block));
+        }
+
+        if(total_row_num != row_num_) throw std::runtime_error("error: Broken binary sample file (row num)");
+    }
+
+    // "num v0 v1 ..." `菑œǂ
+    void load_text(char const* data, std::size_t const size)
+    {
+        auto const node_num = arity_.size();
+        owned_value_.assign(node_num, std::vector<std::uint32_t>());
+
+        char const* it = data;
+        char const* const end = data + size;
+        auto const skip_space = [&]{ while(it != end && (*it == ' ' || *it == '\t' || *it == '\r')) ++it; };
+        auto const read_number = [&]() -> std::uint64_t
+        {
+            skip_space();
+            if(it == end || *it < '0' || '9' < *it) throw std::runtime_error("error: Broken text sample file");
+            std::uint64_t v = 0;
+            while(it != end && '0' <= *it && *it <= '9') v = v * 10 + (*it++ - '0');
+            return v;
+        };
+
+        while(true)
+        {
+            while(it != end && (*it == ' ' || *it == '\t' || *it == '\r' || *it == '\n')) ++it;
+            if(it == end) break;
+
+            auto const num = read_number();
+            owned_count_.push_back(num);
+            sampling_size_ += num;
+            for(std::size_t k = 0; k < node_num; ++k)
+            {
+                auto const value = read_number();
+                if(value >= arity_[k]) throw std::runtime_error("error: Value out of range in text sample file");
+                owned_value_[k].push_back(static_cast<std::uint32_t>(value));
+            }
+        }
+
+        own_rows();
+    }
+
+    // owned_count_owned_value_1ubNƂĎ
+    void own_rows()
+    {
+        row_num_ = owned_count_.size();
+        width_.assign(arity_.size(), sizeof(std::uint32_t));
+
+        block_type block;
+        block.row_num = row_num_;
+        block.count_width = sizeof(std::uint64_t);
+        block.count = reinterpret_cast<unsigned char const*>(owned_count_.data());
+        for(auto const& column : owned_value_)
+            block.column.push_back(reinterpret_cast<unsigned char const*>(column.data()));
+        block_.push_back(std::move(block));
+    }
+
+    std::vector<std::size_t> arity_;
+    std::vector<std::size_t> width_;
+    std::vector<block_type> block_;
+    std::size_t row_num_;
+    std::uint64_t sampling_size_;
+
+    std::unique_ptr<mapped_file> file_;
+    std::vector<std::uint64_t> owned_count_;
+    std::vector<std::vector<std::uint32_t>> owned_value_;
+};
+
+} // namespace bn
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef COMMON_THREAD_POOL_HPP
+#define COMMON_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bn {
+
+// [NXeB[O^̃Xbhv[
+// e[J[͎̃L[̖oCȂ瑼̃L[̐擪瓐
+// dʂ̕΂^XN(: SyA̎Ops̊es)ϓɎJ
+class thread_pool {
+public:
+    explicit thread_pool(std::size_t const thread_num = 0)
+        : pending_(0), queued_(0), stop_(false), next_(0)
+    {
+        auto const num = thread_num != 0 ? thread_num : default_thread_num();
+        for(std::size_t i = 0; i < num; ++i)
+            queues_.push_back(std::unique_ptr<worker_queue>(new worker_queue()));
+        for(std::size_t i = 0; i < num; ++i)
+            threads_.emplace_back([this, i]{ work(i); });
+    }
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        available_.notify_all();
+        for(auto& thread : threads_) thread.join();
+    }
+
+    thread_pool(thread_pool const&) = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+
+    std::size_t size() const
+    {
+        return threads_.size();
+    }
+
+    // ^XNo^(e[J[̃L[֏ɐU蕪)
+    void submit(std::function<void()> task)
+    {
+        std::size_t index;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            index = next_++ % queues_.size();
+            ++pending_;
+            ++queued_;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+            queues_[index]->tasks.push_back(std::move(task));
+        }
+        available_.notify_one();
+    }
+
+    // o^ς݂̃^XNSďI܂ő҂
+    // ^XNO𓊂Ăꍇ͍ŏ1đo
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        finished_.wait(lock, [this]{ return pending_ == 0; });
+
+        if(error_)
+        {
+            auto error = error_;
+            error_ = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    static std::size_t default_thread_num()
+    {
+        auto const num = std::thread::hardware_concurrency();
+        return num != 0 ? num : 1;
+    }
+
+private:
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool try_pop(std::size_t const index, std::function<void()>& task)
+    {
+        // ̃L[͖
+        {
+            auto& own = *queues_[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if(!own.tasks.empty())
+            {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+
+        // ̃L[͐擪瓐
+        for(std::size_t i = 1; i < queues_.size(); ++i)
+        {
+            auto& other = *queues_[(index + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock(other.mutex);
+            if(!other.tasks.empty())
+            {
+                task = std::move(other.tasks.front());
+                other.tasks.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void work(std::size_t const index)
+    {
+        while(true)
+        {
+            std::function<void()> task;
+            if(try_pop(index, task))
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    --queued_;
+                }
+
+                try
+                {
+                    task();
+                }
+                catch(...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if(!error_) error_ = std::current_exception();
+                }
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                if(--pending_ == 0) finished_.notify_all();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            available_.wait(lock, [this]{ return stop_ || queued_ != 0; });
+            if(stop_ && queued_ == 0) return;
+        }
+    }
+
+    std::vector<std::unique_ptr<worker_queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable available_;
+    std::condition_variable finished_;
+    std::size_t pending_;
+    std::size_t queued_;
+    bool stop_;
+    std::size_t next_;
+    std::exception_ptr error_;
+};
+
+} // namespace bn
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef COMMON_THREAD_TIMER_HPP
+#define COMMON_THREAD_TIMER_HPP
+
+#include <cstdint>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace bn {
+
+#if defined(_WIN32)
+inline double user_seconds(FILETIME const& user)
+{
+    auto const ticks = (static_cast<std::uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+    return static_cast<double>(ticks) * 1.0e-7; // from 100 nanoseconds to seconds
+}
+#else
+inline double user_seconds(rusage const& usage)
+{
+    return static_cast<double>(usage.ru_utime.tv_sec) + static_cast<double>(usage.ru_utime.tv_usec) * 1.0e-6;
+}
+#endif
+
+// ĂяoXbh̃[UCPUԂ𑪂^C}
+// boost::timer::cpu_timer̓vZXŜ̎ԂȂ̂ŁCXbhœɊwKƑ̃Xbh̕܂ŐĂ܂
+class thread_cpu_timer {
+public:
+    thread_cpu_timer()
+        : start_(now())
+    {
+    }
+
+    // Jňoߎ[s]
+    double elapsed() const
+    {
+        return now() - start_;
+    }
+
+private:
+    static double now()
+    {
+#if defined(_WIN32)
+        FILETIME creation, exit, kernel, user;
+        if(!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+            throw std::runtime_error("error: Cannot get the thread CPU time");
+        return user_seconds(user);
+#else
+        rusage usage;
+        if(getrusage(RUSAGE_THREAD, &usage) != 0)
+            throw std::runtime_error("error: Cannot get the thread CPU time");
+        return user_seconds(usage);
+#endif
+    }
+
+    double start_;
+};
+
+// vZXS(SẴXbh̘a)̃[UCPUԂ𑪂^C}
+// ̃Xbhv[őwKɎgD̊wKƓɑ点ƁC̕܂ŐĂ܂̂ŁC
+// Ԃ͂̊wK𑖂点邱
+class process_cpu_timer {
+public:
+    process_cpu_timer()
+        : start_(now())
+    {
+    }
+
+    // Jňoߎ[s]
+    double elapsed() const
+    {
+        return now() - start_;
+    }
+
+private:
+    static double now()
+    {
+#if defined(_WIN32)
+        FILETIME creation, exit, kernel, user;
+        if(!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+            throw std::runtime_error("error: Cannot get the process CPU time");
+        return user_seconds(user);
+#else
+        rusage usage;
+        if(getrusage(RUSAGE_SELF, &usage) != 0)
+            throw std::runtime_error("error: Cannot get the process CPU time");
+        return user_seconds(usage);
+#endif
+    }
+
+    double start_;
+};
+
+// 1̊wKg[UCPU(wKSẴXbh̘a)𑪂^C}
+// Ă񂾃XbhőwKthread_cpu_timerŁC̃XbhgwK(exclusive)
+// PƂő点process_cpu_timerőDǂʂŁCPƂő点̃vZXŜ
+// [UCPU(ȑOboost::timer::cpu_timeruser)Ɠ
+class learner_cpu_timer {
+public:
+    explicit learner_cpu_timer(bool const exclusive)
+        : exclusive_(exclusive)
+    {
+    }
+
+    // Jňoߎ[s]
+    double elapsed() const
+    {
+        return exclusive_ ? process_.elapsed() : thread_.elapsed();
+    }
+
+private:
+    bool exclusive_;
+    thread_cpu_timer thread_;
+    process_cpu_timer process_;
+};
+
+} // namespace bn
+
+#endif
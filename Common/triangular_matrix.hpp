@@ -0,0 +1,45 @@
+#ifndef COMMON_TRIANGULAR_MATRIX_HPP
+#define COMMON_TRIANGULAR_MATRIX_HPP
+
+#include <vector>
+
+namespace bn {
+
+// i < j ̗vf (i, j) ݂̂Ops
+// si̗vf͘AĕԂ̂ŁCsɕʃXbh珑ł悢
+template<class T>
+class triangular_matrix {
+public:
+    explicit triangular_matrix(std::size_t const size = 0)
+        : size_(size), data_(size * (size > 0 ? size - 1 : 0) / 2)
+    {
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    T& operator()(std::size_t const i, std::size_t const j)
+    {
+        return data_[index(i, j)];
+    }
+
+    T const& operator()(std::size_t const i, std::size_t const j) const
+    {
+        return data_[index(i, j)];
+    }
+
+private:
+    std::size_t index(std::size_t const i, std::size_t const j) const
+    {
+        return i * (2 * size_ - i - 1) / 2 + (j - i - 1);
+    }
+
+    std::size_t size_;
+    std::vector<T> data_;
+};
+
+} // namespace bn
+
+#endif
@@ -0,0 +1,335 @@
+#ifndef COMMON_VARIABLE_ELIMINATION_HPP
+#define COMMON_VARIABLE_ELIMINATION_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include <bayesian/graph.hpp>
+#include "compiled_network.hpp"
+#include "factor.hpp"
+
+namespace bn {
+namespace inference {
+
+// ϐ@ɂ錵_
+// 쐬ɊeCPTqɒCOtmin-fill̏߂Ă(₢킹m[h͔΂čŌɎc)
+// ₢킹ɂEvidenceƖ₢킹m[h̑ĉ݂̈qEvidenceŏk񂵁C̏ɏ
+// 쐬͕ύXȂ̂ŁCقȂEvidence̖₢킹ăRpCȂɉxł(Xbhł)s
+class variable_elimination {
+public:
+    using evidence_type = std::unordered_map<vertex_type, std::size_t>;
+    using query_type = probability_query;
+
+    explicit variable_elimination(graph_t const& graph)
+        : variable_elimination(std::make_shared<compiled_network const>(graph))
+    {
+    }
+
+    explicit variable_elimination(std::shared_ptr<compiled_network const> network)
+        : network_(std::move(network))
+    {
+        make_factors();
+        make_order();
+    }
+
+    compiled_network const& network() const
+    {
+        return *network_;
+    }
+
+    // ̓rŌq̑傫̏(Evidence}ł傫Ȃ邱Ƃ͂Ȃ)
+    // ₢킹m[h͏ł̈ʒuɊւ炸Ō܂ŎĉŁCeïqɂ
+    // ₢킹m[h蓾D̕(אڂȂm[h̒l̐̍ő)|Čς
+    double max_factor_size() const
+    {
+        return max_factor_size_;
+    }
+
+    // evidencẻłnode̎㕪z
+    // Evidence̊m0̏ꍇ͑S0Ԃ
+    std::vector<double> marginal(evidence_type const& evidence, vertex_type const& node) const
+    {
+        auto const evidence_value = network_->make_evidence(evidence);
+        auto const target = static_cast<std::uint32_t>(network_->position(node));
+
+        // ₢킹m[hEvidenceȂm
+        std::vector<double> result(network_->arity(target), 0.0);
+        if(evidence_value[target] != unobserved)
+        {
+            result[evidence_value[target]] = 1.0;
+            return result;
+        }
+
+        // EvidenceƖ₢킹m[h̑ĉ݂֌W
+        std::vector<std::size_t> roots(1, target);
+        for(std::size_t k = 0; k < evidence_value.size(); ++k)
+        {
+            if(evidence_value[k] != unobserved) roots.push_back(k);
+        }
+        auto const relevant = network_->ancestors(roots);
+
+        std::vector<bool> is_relevant(network_->node_num(), false);
+        for(auto const k : relevant) is_relevant[k] = true;
+
+        std::vector<factor> factors;
+        for(auto const k : relevant) factors.push_back(reduce(factors_[k], evidence_value));
+
+        // ߂Ăŏ
+        for(auto const variable : order_)
+        {
+            if(!is_relevant[variable] || variable == target || evidence_value[variable] != unobserved) continue;
+
+            std::vector<factor const*> related;
+            std::vector<factor> rest;
+            for(auto const& f : factors)
+            {
+                if(std::binary_search(f.variable.begin(), f.variable.end(), variable)) related.push_back(&f);
+            }
+            if(related.empty()) continue;
+
+            auto eliminated = combine(related, variable);
+            for(auto& f : factors)
+            {
+                if(!std::binary_search(f.variable.begin(), f.variable.end(), variable)) rest.push_back(std::move(f));
+            }
+            rest.push_back(std::move(eliminated));
+            factors = std::move(rest);
+        }
+
+        // c͖₢킹m[ĥ݂̈q(܂͒萔)
+        std::vector<factor const*> remaining;
+        for(auto const& f : factors) remaining.push_back(&f);
+        auto const joint = combine(remaining, none);
+
+        double total = 0.0;
+        for(auto const p : joint.table) total += p;
+        if(total <= 0.0) return result;
+
+        if(joint.variable.empty())
+            throw std::runtime_error("error: Query node vanished in variable_elimination");
+
+        for(std::size_t j = 0; j < result.size(); ++j) result[j] = joint.table[j] / total;
+        return result;
+    }
+
+    // ̖₢킹ɓ(parallel_likelihood_weighting::queryƓ`)
+    std::vector<double> query(std::vector<query_type> const& queries) const
+    {
+        std::vector<double> result;
+        result.reserve(queries.size());
+        for(auto const& q : queries)
+            result.push_back(marginal(q.evidence, q.node)[q.value]);
+        return result;
+    }
+
+private:
+    enum : std::uint32_t { none = 0xffffffff };
+
+    // CPTqɒ
+    void make_factors()
+    {
+        for(std::size_t k = 0; k < network_->node_num(); ++k)
+            factors_.push_back(make_cpt_factor(*network_, k));
+    }
+
+    // Otmin-fill(Ȃq̏)̏߂
+    void make_order()
+    {
+        auto const& net = *network_;
+        auto const node_num = net.node_num();
+
+        std::vector<std::set<std::uint32_t>> neighbor(node_num);
+        for(auto const& f : factors_)
+        {
+            for(auto const a : f.variable)
+            {
+                for(auto const b : f.variable)
+                {
+                    if(a != b) neighbor[a].insert(b);
+                }
+            }
+        }
+
+        max_factor_size_ = 1.0;
+        std::vector<bool> eliminated(node_num, false);
+        for(std::size_t step = 0; step < node_num; ++step)
+        {
+            std::uint32_t best = none;
+            std::size_t best_fill = 0;
+            double best_size = 0.0;
+            for(std::uint32_t v = 0; v < node_num; ++v)
+            {
+                if(eliminated[v]) continue;
+
+                std::size_t fill = 0;
+                for(auto a = neighbor[v].begin(); a != neighbor[v].end(); ++a)
+                {
+                    for(auto b = std::next(a); b != neighbor[v].end(); ++b)
+                    {
+                        if(neighbor[*a].count(*b) == 0) ++fill;
+                    }
+                }
+
+                double size = net.arity(v);
+                for(auto const n : neighbor[v]) size *= net.arity(n);
+
+                if(best == none || fill < best_fill || (fill == best_fill && size < best_size))
+                {
+                    best = v;
+                    best_fill = fill;
+                    best_size = size;
+                }
+            }
+
+            // ₢킹m[hɗׂɂȂ΁Cꂪqɉꍇ
+            std::uint32_t extra = 1;
+            for(std::uint32_t v = 0; v < node_num; ++v)
+            {
+                if(v != best && neighbor[best].count(v) == 0) extra = std::max(extra, net.arity(v));
+            }
+
+            order_.push_back(best);
+            eliminated[best] = true;
+            max_factor_size_ = std::max(max_factor_size_, best_size * extra);
+
+            for(auto const a : neighbor[best])
+            {
+                for(auto const b : neighbor[best])
+                {
+                    if(a != b) neighbor[a].insert(b);
+                }
+                neighbor[a].erase(best);
+            }
+            neighbor[best].clear();
+        }
+    }
+
+    // Evidence̕ϐlŌŒ肵Ď菜
+    factor reduce(factor const& source, std::vector<std::size_t> const& evidence) const
+    {
+        factor result;
+        std::vector<std::size_t> stride(source.variable.size());
+        std::size_t step = 1, base = 0;
+        for(std::size_t d = source.variable.size(); d-- > 0;)
+        {
+            auto const v = source.variable[d];
+            stride[d] = step;
+            if(evidence[v] != unobserved) base += evidence[v] * step;
+            step *= network_->arity(v);
+        }
+
+        std::vector<std::size_t> free;
+        for(std::size_t d = 0; d < source.variable.size(); ++d)
+        {
+            if(evidence[source.variable[d]] == unobserved)
+            {
+                result.variable.push_back(source.variable[d]);
+                free.push_back(d);
+            }
+        }
+
+        std::size_t size = 1;
+        for(auto const v : result.variable) size *= network_->arity(v);
+        result.table.resize(size);
+
+        std::vector<std::uint32_t> value(free.size(), 0);
+        auto index = base;
+        for(std::size_t i = 0; i < size; ++i)
+        {
+            result.table[i] = source.table[index];
+
+            for(std::size_t d = free.size(); d-- > 0;)
+            {
+                index += stride[free[d]];
+                if(++value[d] < network_->arity(result.variable[d])) break;
+                index -= stride[free[d]] * value[d];
+                value[d] = 0;
+            }
+        }
+
+        return result;
+    }
+
+    // q̐ςƂCvariable𑫂킹ď(noneȂȂ)
+    factor combine(std::vector<factor const*> const& factors, std::uint32_t const variable) const
+    {
+        std::vector<std::uint32_t> all;
+        for(auto const f : factors) all.insert(all.end(), f->variable.begin(), f->variable.end());
+        std::sort(all.begin(), all.end());
+        all.erase(std::unique(all.begin(), all.end()), all.end());
+
+        factor result;
+        double total_size = 1.0;
+        for(auto const v : all)
+        {
+            total_size *= network_->arity(v);
+            if(v != variable) result.variable.push_back(v);
+        }
+        if(total_size > static_cast<double>(std::numeric_limits<std::uint32_t>::max()))
+            throw std::runtime_error("error: Too large factor for variable_elimination");
+
+        // eqƌʂ́CSϐɂẴXgCh
+        auto const strides = [this, &all](std::vector<std::uint32_t> const& variable)
+        {
+            std::vector<std::size_t> stride(all.size(), 0);
+            std::size_t step = 1;
+            for(std::size_t d = variable.size(); d-- > 0;)
+            {
+                stride[std::lower_bound(all.begin(), all.end(), variable[d]) - all.begin()] = step;
+                step *= network_->arity(variable[d]);
+            }
+            return stride;
+        };
+
+        std::vector<std::vector<std::size_t>> stride;
+        for(auto const f : factors) stride.push_back(strides(f->variable));
+        auto const result_stride = strides(result.variable);
+
+        std::size_t result_size = 1;
+        for(auto const v : result.variable) result_size *= network_->arity(v);
+        result.table.assign(result_size, 0.0);
+
+        auto const size = static_cast<std::size_t>(total_size);
+        std::vector<std::uint32_t> value(all.size(), 0);
+        std::vector<std::size_t> index(factors.size(), 0);
+        std::size_t result_index = 0;
+        for(std::size_t i = 0; i < size; ++i)
+        {
+            double product = 1.0;
+            for(std::size_t f = 0; f < factors.size(); ++f) product *= factors[f]->table[index[f]];
+            result.table[result_index] += product;
+
+            for(std::size_t d = all.size(); d-- > 0;)
+            {
+                auto const arity = network_->arity(all[d]);
+                if(++value[d] < arity)
+                {
+                    for(std::size_t f = 0; f < factors.size(); ++f) index[f] += stride[f][d];
+                    result_index += result_stride[d];
+                    break;
+                }
+
+                for(std::size_t f = 0; f < factors.size(); ++f) index[f] -= stride[f][d] * (arity - 1);
+                result_index -= result_stride[d] * (arity - 1);
+                value[d] = 0;
+            }
+        }
+
+        return result;
+    }
+
+    std::shared_ptr<compiled_network const> network_;
+    std::vector<factor> factors_;
+    std::vector<std::uint32_t> order_;
+    double max_factor_size_;
+};
+
+} // namespace inference
+} // namespace bn
+
+#endif
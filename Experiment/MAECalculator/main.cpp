@@ -1,7 +1,10 @@
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <boost/foreach.hpp>
+#include <boost/optional.hpp>
 #include <boost/algorithm/string/split.hpp>
 
 #define BOOST_SPIRIT_INCLUDE_PHOENIX
@@ -14,20 +17,50 @@
 #include <bayesian/sampler.hpp>
 #include <bayesian/utility.hpp>
 #include <bayesian/inference/likelihood_weighting.hpp>
-#include <bayesian/serializer/bif.hpp>
 #include <bayesian/serializer/csv.hpp>
+#include <Common/adaptive_importance_sampling.hpp>
+#include <Common/column_counter.hpp>
+#include <Common/graph_snapshot.hpp>
+#include <Common/loopy_belief_propagation.hpp>
+#include <Common/parallel_likelihood_weighting.hpp>
+#include <Common/parameter_cache.hpp>
+#include <Common/sample_table.hpp>
+#include <Common/variable_elimination.hpp>
 
 std::size_t const MAE_REPEAT_NUM = 10;
-std::size_t const INFERENCE_SAMPLE_SIZE = 1000000;
+std::size_t const INFERENCE_SAMPLE_SIZE = 1000000; // ~^ꍇ̓Tv̏
+std::size_t const AIS_SAMPLE_SIZE = 100000;        // AIS-BÑTv(dvxCPTwK̂LW1ȂD~^ꍇ͏)
+std::size_t const INFERENCE_CHUNK_SIZE = 10000;     // ~𒲂ׂԊu
+double const EXACT_FACTOR_LIMIT = 1 << 24; // _sq̑傫̏
+
+// _̐ݒ
+struct inference_option {
+    std::size_t thread_num;
+    boost::optional<std::uint32_t> seed;
+    std::string method; // Ȃ(_CPTȂlibraryCx琄肷Ȃlw)
+    double precision; // 95%MԂ̖̔ڕW(0ȂwȂ)
+    double min_ess;   // LTv̉(0ȂwȂ)
+    bool fast_cpt;    // CPTsampler::make_cptłȂx璼ڐ肷(w莞̂݁D͏]ǂmake_cpt)
+};
 
 auto process_command_line(int argc, char* argv[])
-    -> std::tuple<std::vector<std::string>, std::string>
+    -> std::tuple<std::vector<std::string>, std::string, inference_option>
 {
     boost::program_options::options_description opt("Option");
     opt.add_options()
         ("help,h",                                                                 "Show this help")
         ("directory,d", boost::program_options::value<std::vector<std::string>>(), "Target Graph Directories")
-        ("eqlist,l"   , boost::program_options::value<std::string>()             , "Evidence/Query Data Path");
+        ("eqlist,l"   , boost::program_options::value<std::string>()             , "Evidence/Query Data Path")
+        ("thread,t"   , boost::program_options::value<std::size_t>()             , "Inference Thread Num for lw, ais and bp (default: all cores; library always runs on one thread)")
+        ("seed"       , boost::program_options::value<std::uint32_t>()           , "Inference Random Seed for lw and ais (results also depend on --thread)")
+        ("inference,i", boost::program_options::value<std::string>()             , "Inference Method (default: library, or lw when CPTs are estimated from counts)\n"
+                                                                                   "  library: bn::inference::likelihood_weighting, one query at a time (same as earlier runs)\n"
+                                                                                   "  lw     : parallel likelihood weighting on --thread cores; numbers differ from library and depend on --thread/--seed\n"
+                                                                                   "  auto   : exact VE for the teacher if feasible, lw for learned graphs; does not reproduce eqlists made by earlier runs\n"
+                                                                                   "  ve, ais, bp: exact, AIS-BN and loopy belief propagation for every graph")
+        ("precision"  , boost::program_options::value<double>()                  , "LW/AIS: Stop when 95% interval half-width of every query falls below this")
+        ("min-ess"    , boost::program_options::value<double>()                  , "LW/AIS: Stop only after effective sample size reaches this")
+        ("fast-cpt"   ,                                                            "Opt-in: estimate CPTs from sample counts outside the graph vertices and cache them per structure, recounting only families whose parent set changed (unseen parent rows become uniform; may differ from sampler::make_cpt). Default: sampler::make_cpt, one graph at a time (binary sample files always use --fast-cpt)");
 
 	boost::program_options::variables_map vm;
 	store(parse_command_line(argc, argv, opt), vm);
@@ -46,12 +79,86 @@ auto process_command_line(int argc, char* argv[])
         std::exit(0);
     }
 
+    inference_option option{0, boost::none, "", 0.0, 0.0, false};
+    if(vm.count("thread"))    option.thread_num = vm["thread"].as<std::size_t>();
+    if(vm.count("seed"))      option.seed = vm["seed"].as<std::uint32_t>();
+    if(vm.count("inference")) option.method = vm["inference"].as<std::string>();
+    if(vm.count("precision")) option.precision = vm["precision"].as<double>();
+    if(vm.count("min-ess"))   option.min_ess = vm["min-ess"].as<double>();
+    if(vm.count("fast-cpt"))  option.fast_cpt = true;
+
+    if(!option.method.empty() && option.method != "library" && option.method != "auto" && option.method != "ve" && option.method != "lw" && option.method != "ais" && option.method != "bp")
+        throw std::runtime_error("error: Unknown inference method (" + option.method + ")");
+
+    // ~̓TvOɂ鐄_(autoł͊wKʂ̃Ot)ɂȂ
+    if((option.precision > 0.0 || option.min_ess > 0.0) && option.method != "auto" && option.method != "lw" && option.method != "ais")
+        throw std::runtime_error("error: --precision and --min-ess are only for --inference auto, lw or ais");
+
     return std::make_tuple(
         vm["directory"].as<std::vector<std::string>>(),
-        vm["eqlist"].as<std::string>()
+        vm["eqlist"].as<std::string>(),
+        option
         );
 }
 
+// Ot̃p[^(CPT)̋ߕ
+// łsampler::make_cptŒ_CPTCǂݏo(Ot1邱)
+// l]ƕςȂߊ͂̂܂܂ŁC_؂藣p[^--fast-cptw莞̂ݎg
+// fast_cptł̓Tv̓x璼ڐ肵C\ɋL(parameter_cache)
+// (e̒l̑gTvɌȂs͈lzƂ̂ŁCmake_cptƒlvƂ͌Ȃ)
+// bn::sampler̓eLXg`ǂ߂Ȃ̂ŁCoCi`̃Tv͎w肪ȂĂx琄肷
+class parameter_source {
+public:
+    using parameter_type = bn::parameter_cache<bn::column_counter>::parameter_type;
+
+    parameter_source(boost::filesystem::path const& sample_path, bn::graph_t const& teacher_graph, bool const fast_cpt)
+    {
+        if(fast_cpt || bn::binary_sample::is_binary_file(sample_path.string()))
+        {
+            // TvwɓWJ
+            bn::sample_table table;
+            table.load(sample_path.string(), teacher_graph.vertex_list());
+            counter_.reset(new bn::column_counter(table));
+            cache_.reset(new bn::parameter_cache<bn::column_counter>(*counter_));
+        }
+        else
+        {
+            sampler_.set_filename(sample_path.string());
+            sampler_.load_sample(teacher_graph.vertex_list());
+        }
+    }
+
+    parameter_source(parameter_source const&) = delete;
+    parameter_source& operator=(parameter_source const&) = delete;
+
+    // x琄肵Ă邩(--fast-cptw莞ƃoCi`̃Tv)
+    bool counts() const
+    {
+        return static_cast<bool>(cache_);
+    }
+
+    parameter_type operator()(bn::graph_t const& graph)
+    {
+        if(cache_) return (*cache_)(graph);
+
+        sampler_.make_cpt(graph);
+        return std::make_shared<bn::compiled_network const>(graph);
+    }
+
+private:
+    bn::sampler sampler_;
+    std::unique_ptr<bn::column_counter> counter_;
+    std::unique_ptr<bn::parameter_cache<bn::column_counter>> cache_;
+};
+
+// ݒɏ]Ċm_
+bn::inference::parallel_likelihood_weighting make_inference_engine(parameter_source::parameter_type const& parameter, inference_option const& option)
+{
+    bn::inference::parallel_likelihood_weighting lhw(parameter, option.thread_num);
+    if(option.seed) lhw.seed(option.seed.get());
+    return lhw;
+}
+
 struct calculate_target {
     std::pair<bn::vertex_type, std::size_t> query;
     std::unordered_map<bn::vertex_type, std::size_t> evidence;
@@ -155,29 +262,130 @@ std::vector<calculate_target> generate_inference_target(Engine& engine, bn::grap
     return inference_target;
 }
 
+// _ւ̖₢킹ɒ
+std::vector<bn::inference::probability_query> make_queries(std::vector<calculate_target> const& target)
+{
+    std::vector<bn::inference::probability_query> queries;
+    for(auto const& elem : target)
+        queries.push_back({elem.evidence, elem.query.first, elem.query.second});
+    return queries;
+}
+
+// ~𖞂܂INFERENCE_CHUNK_SIZE(Xmax_sample_num)TvOē
+template<class Engine>
+std::vector<double> stopped_query(
+    std::string const& name, Engine& engine, std::vector<bn::inference::probability_query> const& queries,
+    inference_option const& option, std::size_t const max_sample_num)
+{
+    auto const half_width = option.precision > 0.0 ? option.precision : std::numeric_limits<double>::infinity();
+    auto const report = engine.query(queries, bn::inference::stopping_rule{half_width, option.min_ess, INFERENCE_CHUNK_SIZE, max_sample_num});
+    if(!queries.empty())
+    {
+        std::cout << name << ": min ESS = " << *std::min_element(report.ess.begin(), report.ess.end())
+                  << ", max samples = " << *std::max_element(report.sample_num.begin(), report.sample_num.end()) << std::endl;
+    }
+    return report.probability;
+}
+
+// SĂ̖₢킹ɂ܂Ƃ߂ē
+// library: Cubn::inference::likelihood_weighting(INFERENCE_SAMPLE_SIZED1C1XbhœD)
+//          _CPTǂނ̂ŁCsampler::make_cptŒ_ɏgraphn
+// ve: ϐ@(_DȂ傫ȂO)
+// lw: Likelihood Weighting(INFERENCE_SAMPLE_SIZE)Cais: dvxCPTwKdvxTvO(AIS-BNDAIS_SAMPLE_SIZE)
+// bp: Loopy Belief Propagation(I)
+// auto: (teachertrue)͈傫Ȃϐ@ŁCȂLikelihood Weighting
+//       wKʂ̃Ot͏Likelihood Weighting
+//       (wKʂ̃Otɐ_@ςMAEׂȂ̂ŁCwKʂɂ͏ɓ_@g)
+//       ƊwKʂŐ_@Ⴂ̂ŁC߂_@Wo͂ɏ
+std::vector<double> infer(
+    bn::graph_t const& graph, parameter_source::parameter_type const& parameter,
+    std::vector<calculate_target> const& target, inference_option const& option, bool const teacher)
+{
+    auto const report = [teacher](std::string const& engine)
+    {
+        if(teacher) std::cout << "Ground Truth: " << engine << std::endl;
+    };
+
+    if(option.method == "library")
+    {
+        report("bn::inference::likelihood_weighting");
+        bn::inference::likelihood_weighting lhw(graph);
+
+        std::vector<double> result;
+        for(auto const& elem : target)
+        {
+            auto const inference = lhw(elem.evidence, INFERENCE_SAMPLE_SIZE);
+            result.push_back(inference.at(elem.query.first)[0][elem.query.second]);
+        }
+        return result;
+    }
+
+    auto const queries = make_queries(target);
+    if(option.method == "ve")
+    {
+        report("variable elimination (exact)");
+        bn::inference::variable_elimination ve(parameter);
+        if(ve.max_factor_size() > EXACT_FACTOR_LIMIT)
+            throw std::runtime_error("error: The graph is too large for exact inference; use another --inference");
+        return ve.query(queries);
+    }
+
+    if(option.method == "bp")
+    {
+        report("loopy belief propagation");
+        bn::inference::loopy_belief_propagation bp(parameter, option.thread_num);
+        return bp.query(queries);
+    }
+
+    if(option.method == "ais")
+    {
+        report("AIS-BN");
+        bn::inference::adaptive_importance_sampling ais(parameter, option.thread_num);
+        if(option.seed) ais.seed(option.seed.get());
+        if(option.precision <= 0.0 && option.min_ess <= 0.0)
+            return ais.query(queries, AIS_SAMPLE_SIZE);
+
+        return stopped_query("AIS", ais, queries, option, AIS_SAMPLE_SIZE);
+    }
+
+    if(option.method == "auto" && teacher)
+    {
+        bn::inference::variable_elimination ve(parameter);
+        if(ve.max_factor_size() <= EXACT_FACTOR_LIMIT)
+        {
+            report("variable elimination (exact; learned graphs use parallel likelihood weighting)");
+            return ve.query(queries);
+        }
+    }
+
+    report("parallel likelihood weighting");
+    auto lhw = make_inference_engine(parameter, option);
+    if(option.precision <= 0.0 && option.min_ess <= 0.0)
+        return lhw.query(queries, INFERENCE_SAMPLE_SIZE);
+
+    return stopped_query("LW", lhw, queries, option, INFERENCE_SAMPLE_SIZE);
+}
+
 // Mean Absolute Error
-double caluculate_mae(bn::graph_t const& graph, bn::sampler const& sampler, std::vector<calculate_target> const target)
+double caluculate_mae(bn::graph_t const& graph, parameter_source& parameters, std::vector<calculate_target> const target, inference_option const& option)
 {
     // CPŤvZ
-    sampler.make_cpt(graph);
+    auto const parameter = parameters(graph);
 
-    // m_̍쐬
-    bn::inference::likelihood_weighting lhw(graph);
+    // _
+    auto const inference = infer(graph, parameter, target, option, false);
 
     double mae = 0.0;
-    for(auto const& elem : target)
+    for(std::size_t i = 0; i < target.size(); ++i)
     {
-        // _
-        auto const inference = lhw(elem.evidence, INFERENCE_SAMPLE_SIZE);
-
         // ̌vZ
-        mae += std::abs(inference.at(elem.query.first)[0][elem.query.second] - elem.inference) / MAE_REPEAT_NUM;
+        mae += std::abs(inference[i] - target[i].inference) / MAE_REPEAT_NUM;
     }
 
     return mae;
 }
 
-void process_each_graph(bn::graph_t const& teacher_graph, bn::sampler const& sampler, boost::filesystem::path const& result_path, std::vector<calculate_target> const target)
+void process_each_graph(bn::graph_t const& teacher_graph, parameter_source& parameters, boost::filesystem::path const& result_path, std::vector<calculate_target> const target, inference_option const& option)
 {
     // ƃpX
     boost::filesystem::path const working_directory = result_path.parent_path();
@@ -215,7 +423,7 @@ void process_each_graph(bn::graph_t const& teacher_graph, bn::sampler const& sam
             bn::serializer::csv().load(graph_ifs, graph);
 
             // MAEvZ
-            auto const mae = caluculate_mae(graph, sampler, target);
+            auto const mae = caluculate_mae(graph, parameters, target, option);
             total_mae += mae;
             line[3] = std::to_string(mae);
             std::cout << mae << std::endl; // Debug
@@ -240,9 +448,10 @@ int main(int argc, char* argv[])
     // R}hCp[X
     boost::filesystem::path eqlist_path;
     std::vector<boost::filesystem::path> target_directory_paths;
+    inference_option option;
     {
         std::vector<std::string> target_directories;
-        std::tie(target_directories, eqlist_path) = process_command_line(argc, argv);
+        std::tie(target_directories, eqlist_path, option) = process_command_line(argc, argv);
         std::transform(
             std::begin(target_directories), std::end(target_directories),
             std::back_inserter(target_directory_paths),
@@ -261,8 +470,9 @@ int main(int argc, char* argv[])
             boost::filesystem::path const& path,
             std::make_pair(boost::filesystem::recursive_directory_iterator(target_directory), boost::filesystem::recursive_directory_iterator()))
         {
-            if(path.extension() == ".bif")
+            if(path.extension() == ".bif" || (path.extension() == ".bnsnap" && network_path.empty()))
             {
+                // XibvVbg𒼐ڎĝBIFꍇ̂(BIFΉőΉ̂T)
                 network_path = path;
             }
             else if(path.extension() == ".sample")
@@ -275,29 +485,50 @@ int main(int argc, char* argv[])
             }
         }
 
+        // BIFƓÕXibvVbgBIFV΁Cǂ(BIF̌ÂXibvVbg͎gȂ)
+        if(network_path.extension() == ".bif")
+        {
+            auto snapshot_path = network_path;
+            snapshot_path.replace_extension(".bnsnap");
+
+            boost::system::error_code snapshot_ec, bif_ec;
+            auto const snapshot_time = boost::filesystem::last_write_time(snapshot_path, snapshot_ec);
+            auto const bif_time = boost::filesystem::last_write_time(network_path, bif_ec);
+            if(!snapshot_ec && !bif_ec && snapshot_time > bif_time)
+                network_path = snapshot_path;
+        }
+
         std::cout << "Starting..." << std::endl;
         std::cout << "Net: " << network_path << std::endl;
         std::cout << "Sam: " << sample_path << std::endl;
         for(auto const& result_path : result_paths)
             std::cout << result_path << std::endl;
 
-        // Ott@CJgraph_dataɓ
-        boost::filesystem::ifstream ifs(network_path);
-        std::string const graph_data{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
-        ifs.close();
-        std::cout << "Loaded Graph: Length = " << graph_data.size() << std::endl;
-
-        // graph_dataOtp[X
+        // Ott@Cǂݍ(.bnsnapȂXibvVbgCȊOBIF)
         bn::graph_t teacher_graph;
         bn::database_t data;
-        std::tie(teacher_graph, data) = bn::serializer::bif().parse(graph_data.cbegin(), graph_data.cend());
+        std::tie(teacher_graph, data) = bn::serializer::load_graph(network_path.string());
         std::cout << "Parsed Graph: Num of Node = " << teacher_graph.vertex_list().size() << std::endl;
 
-        // Tvɓǂݍ܂
-        bn::sampler sampler;
-        sampler.set_filename(sample_path.string());
-        sampler.load_sample(teacher_graph.vertex_list());
+        // Tvǂݍ
+        parameter_source parameters(sample_path, teacher_graph, option.fast_cpt);
         std::cout << "Loaded Sample" << std::endl;
+        if(parameters.counts() && !option.fast_cpt)
+            std::cout << "Binary sample file: CPTs are estimated from sample counts (as --fast-cpt)" << std::endl;
+
+        // library͒_CPTǂނ̂ŁCx琄肷(_ɏ܂Ȃ)Ƃ͎gȂ
+        // w肪Ȃ΁C_CPTȂlibraryCx琄肷ȂlwŐ_
+        auto directory_option = option;
+        if(directory_option.method.empty())
+            directory_option.method = parameters.counts() ? "lw" : "library";
+        else if(directory_option.method == "library" && parameters.counts())
+            throw std::runtime_error("error: --inference library needs CPTs made by sampler::make_cpt; use another --inference with --fast-cpt or a binary sample file");
+        std::cout << "Inference: " << directory_option.method << std::endl;
+
+        // fast_cptł́CwKʂ̃Ot͋tOtƐ{̕ӂȂƂ̂ŁC
+        // tOt̉ƑɐĂCeOtł͐eW̕ςm[ĥݐ
+        // (make_cptł́C]ǂeOt̑Sm[hCPT蒼)
+        if(parameters.counts()) parameters(teacher_graph);
 
         // Evidence/QueryΓǂݍ݁CȂΐ
         std::vector<calculate_target> targets;
@@ -319,13 +550,11 @@ int main(int argc, char* argv[])
             targets = generate_inference_target<std::mt19937>(engine, teacher_graph);
 
             // _
-            sampler.make_cpt(teacher_graph);
-            bn::inference::likelihood_weighting lhw(teacher_graph);
-            for(auto& target : targets)
+            auto const inference = infer(teacher_graph, parameters(teacher_graph), targets, directory_option, true);
+            for(std::size_t i = 0; i < targets.size(); ++i)
             {
-                auto const inference = lhw(target.evidence, INFERENCE_SAMPLE_SIZE);
-                target.inference = inference.at(target.query.first)[0][target.query.second];
-                std::cout << "target.inference = " << target.inference << "\n" << std::endl;
+                targets[i].inference = inference[i];
+                std::cout << "target.inference = " << targets[i].inference << "\n" << std::endl;
             }
 
             // 
@@ -337,7 +566,7 @@ int main(int argc, char* argv[])
         for(auto const& result_path : result_paths)
         {
             std::cout << "Start: " << result_path << std::endl;
-            process_each_graph(teacher_graph, sampler, result_path, targets);
+            process_each_graph(teacher_graph, parameters, result_path, targets, directory_option);
         }
 
         std::cout << std::endl;
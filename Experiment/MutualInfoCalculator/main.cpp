@@ -1,5 +1,10 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <memory>
 #include <random>
+#include <sstream>
+#include <stdexcept>
 
 #define BOOST_SPIRIT_INCLUDE_PHOENIX
 #include <boost/phoenix/phoenix.hpp>
@@ -11,19 +16,27 @@
 #include <bayesian/sampler.hpp>
 #include <bayesian/utility.hpp>
 #include <bayesian/inference/likelihood_weighting.hpp>
-#include <bayesian/serializer/bif.hpp>
 #include <bayesian/serializer/dot.hpp>
 #include <bayesian/evaluation/transinformation.hpp>
+#include <Common/bitset_graph.hpp>
+#include <Common/graph_snapshot.hpp>
+#include <Common/pairwise_mutual_information.hpp>
+#include <Common/sample_table.hpp>
+#include <Common/thread_pool.hpp>
+#include <Common/triangular_matrix.hpp>
 
 auto process_command_line(int argc, char* argv[])
-    -> std::tuple<std::string, std::string, std::string>
+    -> std::tuple<std::string, std::string, std::string, std::size_t, bool, std::size_t>
 {
     boost::program_options::options_description opt("Option");
     opt.add_options()
         ("help,h",                                                  "Show this help")
         ("network,n", boost::program_options::value<std::string>(), "Network Path")
         ("sample,s",  boost::program_options::value<std::string>(), "Sample Path")
-        ("output,o",  boost::program_options::value<std::string>(), "Output Path");
+        ("output,o",  boost::program_options::value<std::string>(), "Output Path")
+        ("thread,t",  boost::program_options::value<std::size_t>(), "Thread Num (default: all cores)")
+        ("each,e",                                                  "Compute pair by pair with the library MI on one sampler (text sample)")
+        ("check,c",   boost::program_options::value<std::size_t>(), "Compare this many pairs with the library MI (text sample)");
 
 	boost::program_options::variables_map vm;
 	store(parse_command_line(argc, argv, opt), vm);
@@ -42,33 +55,117 @@ auto process_command_line(int argc, char* argv[])
         std::exit(0);
     }
 
+    if(vm.count("check") && vm.count("each"))
+    {
+        std::cout << "--check cannot be used with --each" << std::endl;
+        std::exit(0);
+    }
+
     return std::make_tuple(
         vm["network"].as<std::string>(),
         vm["sample"].as<std::string>(),
-        vm["output"].as<std::string>()
+        vm["output"].as<std::string>(),
+        vm.count("thread") ? vm["thread"].as<std::size_t>() : 0,
+        vm.count("each") != 0,
+        vm.count("check") ? vm["check"].as<std::size_t>() : 0
         );
 }
 
+// bn::samplerg1΂vZ(]̌vZ)
+// bn::sampler̓XbhԂŋLłCXbhɓǂݍނƃTv̕XbĥŁC
+// Tv1ǂݍ݁CĂ񂾃XbhŏɌvZ
+bn::triangular_matrix<double> calculate_mi_each(std::string const& sample_path, std::vector<bn::vertex_type> const& vertex_list)
+{
+    // Tvɓǂݍ܂(bn::sampler̓eLXg`ǂ߂Ȃ)
+    if(bn::binary_sample::is_binary_file(sample_path))
+        throw std::runtime_error("error: " + sample_path + " is a binary sample file; --each needs a text sample file");
+    bn::sampler sampler;
+    sampler.set_filename(sample_path);
+    sampler.load_sample(vertex_list);
+    std::cout << "Loaded Sample: " << sampler.sampling_size() << std::endl;
+
+    bn::triangular_matrix<double> mi_matrix(vertex_list.size());
+    bn::evaluation::mutual_information mi_machine;
+    for(std::size_t i = 0; i < vertex_list.size(); ++i)
+    {
+        for(std::size_t j = i + 1; j < vertex_list.size(); ++j)
+            mi_matrix(i, j) = mi_machine(sampler, vertex_list[i], vertex_list[j]);
+    }
+
+    return mi_matrix;
+}
+
+// Tvwɓǂݍ݁CS΂̓px\xɐČvZ()
+// Tv1xǂݍ݁CSẴXbhǂނŋL
+bn::triangular_matrix<double> calculate_mi_bulk(std::string const& sample_path, std::vector<bn::vertex_type> const& vertex_list, bn::thread_pool& pool)
+{
+    bn::sample_table table;
+    table.load(sample_path, vertex_list);
+    std::cout << "Loaded Sample: " << table.sampling_size() << std::endl;
+
+    return bn::evaluation::pairwise_mutual_information()(table, pool);
+}
+
+// ꊇvŽʂbn::evaluation::mutual_informationƓ˂킹
+// S΂̂check_num΂𓙊ԊuɑI1΂vZCΌ덷tolerance𒴂O𓊂
+// (ΐ̒`Ⴆ΁CႦΒ2Ȃ䂪1/log(2)ɂȂČo)
+void check_mi(
+    std::string const& sample_path, std::vector<bn::vertex_type> const& vertex_list,
+    bn::triangular_matrix<double> const& mi_matrix, std::size_t const check_num)
+{
+    double const tolerance = 1e-9;
+
+    if(bn::binary_sample::is_binary_file(sample_path))
+        throw std::runtime_error("error: --check needs a text sample file (bn::sampler cannot read " + sample_path + ")");
+    bn::sampler sampler;
+    sampler.set_filename(sample_path);
+    sampler.load_sample(vertex_list);
+
+    std::vector<std::pair<std::size_t, std::size_t>> pairs;
+    for(std::size_t i = 0; i < vertex_list.size(); ++i)
+        for(std::size_t j = i + 1; j < vertex_list.size(); ++j)
+            pairs.emplace_back(i, j);
+
+    auto const num = std::min(check_num, pairs.size());
+    bn::evaluation::mutual_information mi_machine;
+    double max_error = 0.0;
+    for(std::size_t n = 0; n < num; ++n)
+    {
+        auto const& pair = pairs[n * pairs.size() / num];
+        auto const bulk_mi = mi_matrix(pair.first, pair.second);
+        auto const library_mi = mi_machine(sampler, vertex_list[pair.first], vertex_list[pair.second]);
+        auto const error = std::abs(bulk_mi - library_mi) / std::max(1.0, std::abs(library_mi));
+        max_error = std::max(max_error, error);
+
+        if(error > tolerance)
+        {
+            std::ostringstream message;
+            message << "error: Bulk MI differs from the library MI for ("
+                    << vertex_list[pair.first]->id << ", " << vertex_list[pair.second]->id << "): "
+                    << bulk_mi << " vs " << library_mi;
+            throw std::runtime_error(message.str());
+        }
+    }
+
+    std::cout << "Checked MI: " << num << " pairs, max relative error = " << max_error << std::endl;
+}
+
 int main(int argc, char* argv[])
 {
     // R}hCp[X
     std::string network_path;
     std::string sample_path;
     std::string output_path;
-    std::tie(network_path, sample_path, output_path) = process_command_line(argc, argv);
+    std::size_t thread_num;
+    bool each;
+    std::size_t check_num;
+    std::tie(network_path, sample_path, output_path, thread_num, each, check_num) = process_command_line(argc, argv);
 
-    // Ott@CJgraph_dataɓ
-    std::ifstream ifs(network_path);
-    std::string const graph_data{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
-    ifs.close();
-    std::cout << "Loaded Graph: Length = " << graph_data.size() << std::endl;
-
-    // graph_dataOtp[X
+    // Ott@Cǂݍ(.bnsnapȂXibvVbgCȊOBIF)
     bn::graph_t graph;
     bn::database_t data;
-    std::tie(graph, data) = bn::serializer::bif().parse(graph_data.cbegin(), graph_data.cend());
+    std::tie(graph, data) = bn::serializer::load_graph(network_path);
     auto const& vertex_list = graph.vertex_list();
-    auto const& edge_list = graph.edge_list();
     std::cout << "Parsed Graph: Num of Node = " << vertex_list.size() << std::endl;
 
     for(auto const& vertex : vertex_list)
@@ -76,32 +173,33 @@ int main(int argc, char* argv[])
         std::cout << vertex->id << ": " << vertex->selectable_num << std::endl;
     }
 
-    // Tvɓǂݍ܂
-    bn::sampler sampler;
-    sampler.set_filename(sample_path);
-    sampler.load_sample(graph.vertex_list());
-    std::cout << "Loaded Sample: " << sampler.sampling_size() << std::endl;
-
     // vZ܂
     auto const maximum_edge = vertex_list.size() * (vertex_list.size() - 1) / 2;
-    std::vector<std::tuple<bn::vertex_type, bn::vertex_type, double>> mi_list;
+    std::vector<std::tuple<std::size_t, std::size_t, double>> mi_list;
     mi_list.reserve(maximum_edge);
 
     // ݏʂvZ
+    auto const mi_matrix = [&]
+    {
+        if(each) return calculate_mi_each(sample_path, vertex_list);
+        bn::thread_pool pool(thread_num);
+        return calculate_mi_bulk(sample_path, vertex_list, pool);
+    }();
+    std::cout << "Calculated MI" << std::endl;
+    if(check_num != 0) check_mi(sample_path, vertex_list, mi_matrix, check_num);
+
+    // Wv͏]Ɠōs
     double average_mi = 0.0;
     double maximum_mi = std::numeric_limits<double>::min();
     for(std::size_t i = 0; i < vertex_list.size(); ++i)
     {
         for(std::size_t j = i + 1; j < vertex_list.size(); ++j)
         {
-            bn::evaluation::mutual_information mi_machine;
-            auto const mi = mi_machine(sampler, vertex_list[i], vertex_list[j]);
-            mi_list.emplace_back(vertex_list[i], vertex_list[j], mi);
+            auto const mi = mi_matrix(i, j);
+            mi_list.emplace_back(i, j, mi);
 
             average_mi += mi / maximum_edge;
             maximum_mi = std::max(maximum_mi, mi);
-
-            std::cout << "(" << i << "," << j << ")\n";
         }
     }
     /*
@@ -125,27 +223,15 @@ int main(int argc, char* argv[])
     ofs << "Maximum:," << maximum_mi << "\n";
     ofs << "\n";
 
+    // ӂ̗L͗אڍsň(Ζɕӂ̃Xg𑖍Ȃ)
+    bn::bitset_graph const adjacency(graph);
     for(auto const elem : mi_list)
     {
-        auto const is_connect = std::any_of(
-            edge_list.begin(), edge_list.end(),
-            [&graph, &elem](bn::edge_type const& edge)
-            {
-                auto const source = graph.source(edge);
-                auto const target = graph.target(edge);
-
-                if(std::get<0>(elem) == source && std::get<1>(elem) == target)
-                    return true;
-
-                if(std::get<1>(elem) == source && std::get<0>(elem) == target)
-                    return true;
-
-                return false;
-            });
+        auto const is_connect = adjacency.is_connected(std::get<0>(elem), std::get<1>(elem));
 
-        ofs << data.node_name[std::get<0>(elem)->id] << ",";
+        ofs << data.node_name[vertex_list[std::get<0>(elem)]->id] << ",";
         ofs << (is_connect ? "-" : "")  << ",";
-        ofs << data.node_name[std::get<1>(elem)->id] << ",";
+        ofs << data.node_name[vertex_list[std::get<1>(elem)]->id] << ",";
         ofs << std::get<2>(elem) << "\n";
     }
     ofs.close();
@@ -1,37 +1,58 @@
-#include <boost/timer/timer.hpp>
+#include <unordered_map>
+#include <Common/thread_timer.hpp>
 #include "graph_evaluater.hpp"
 #include "algorithms.hpp"
 
+// graph̕ӂCɕteacher_graph̒_̊Ԃɒ蒼Ot
+bn::graph_t on_teacher_vertices(bn::graph_t const& teacher_graph, bn::graph_t const& graph)
+{
+    auto const& teacher_nodes = teacher_graph.vertex_list();
+    auto const& nodes = graph.vertex_list();
+    if(nodes == teacher_nodes) return graph;
+
+    std::unordered_map<bn::vertex_type, std::size_t> index;
+    for(std::size_t i = 0; i < nodes.size(); ++i) index[nodes[i]] = i;
+
+    auto result = teacher_graph;
+    result.erase_all_edge();
+    for(auto const& edge : graph.edge_list())
+        result.add_edge(teacher_nodes[index.at(graph.source(edge))], teacher_nodes[index.at(graph.target(edge))]);
+
+    return result;
+}
+
 result_t learning(
     bn::graph_t const& teacher_graph,
+    bn::graph_t const& work_graph,
     bn::sampler const& sampler,
-    std::function<double(bn::graph_t& graph, bn::sampler const& sampler)> func)
+    std::function<double(bn::graph_t& graph, bn::sampler const& sampler, std::size_t iteration)> func,
+    std::size_t const iteration,
+    bool const exclusive)
 {
     // Ot̕ӂSč폜
-    auto graph = teacher_graph;
+    auto graph = work_graph;
     graph.erase_all_edge();
 
-    // wK
-    boost::timer::cpu_timer timer;
-    auto const score = func(graph, sampler);
+    // wK(Ԃ͑SĂ̍sŁuwKg[UCPUԁvDbn::learner_cpu_timerQ)
+    bn::learner_cpu_timer const timer(exclusive);
+    auto const score = func(graph, sampler, iteration);
 
     // vl̎擾
-    timer.stop();
     auto const elapsed = timer.elapsed();
 
-    // N̐グ
-    auto const disappeared_link = count_disappeared_link(teacher_graph, graph);
-
-    // N̐グ
-    auto const appeared_link = count_appeared_link(teacher_graph, graph);
+    // ȍ~͋tOt̒_ň
+    graph = on_teacher_vertices(teacher_graph, graph);
 
-    // ]N̐グ
-    auto const reversed_link = count_reversed_link(teacher_graph, graph);
+    // EE]N̐グ(ӂ̍1x߂)
+    bn::graph_diff const diff(teacher_graph, graph);
+    auto const disappeared_link = diff.disappeared().size();
+    auto const appeared_link = diff.appeared().size();
+    auto const reversed_link = diff.reversed().size();
 
     return result_t{
         std::move(graph),
         score,
-        static_cast<double>(elapsed.user) * 1.0e-9, // from nanoseconds to seconds
+        elapsed,
         std::numeric_limits<double>::quiet_NaN(),
         disappeared_link,
         appeared_link,
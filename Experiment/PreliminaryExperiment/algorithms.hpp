@@ -19,10 +19,19 @@ struct result_t {
     double      change_mi;
 };
 
+// work_graph͋tOtƓɒ_񂾃Ot(tOtgł悢)
+// wKwork_graph̒_ōsCʂ̕ӂ͋tOt̒_ɕtւĕԂ
+// (result_t::time)͊wKg[UCPU[s]ŁCSĂ̊wKœ`(bn::learner_cpu_timer)
+// PƂő点̃vZXŜ̃[UCPUԂƓCȑOresult.csvƔׂ
+// iteration͎sԍŁĈ܂func֓n
+// exclusiveȂ(̃XbhőwK̂)vZXŜCPUԂő̂ŁC̊wKƓɌĂł͂ȂȂ
 result_t learning(
     bn::graph_t const& teacher_graph,
+    bn::graph_t const& work_graph,
     bn::sampler const& sampler,
-    std::function<double(bn::graph_t& graph, bn::sampler const& sampler)> func
+    std::function<double(bn::graph_t& graph, bn::sampler const& sampler, std::size_t iteration)> func,
+    std::size_t const iteration,
+    bool const exclusive = false
     );
 
 #endif
@@ -1,19 +1,148 @@
 #define DEBUG_LOG_ 1
 
+#include <cstdint>
+#include <fstream>
+#include <boost/optional.hpp>
 #include <bayesian/evaluation/mdl.hpp>
 #include <bayesian/learning/brute_force.hpp>
 #include <bayesian/learning/greedy.hpp>
 #include <bayesian/learning/simulated_annealing.hpp>
 #include <bayesian/learning/stepwise_structure.hpp>
 #include <bayesian/learning/stepwise_structure_hc.hpp>
+#include <Common/cached_evaluation.hpp>
+#include <Common/cached_greedy.hpp>
+#include <Common/adtree.hpp>
+#include <Common/column_counter.hpp>
+#include <Common/family_score.hpp>
+#include <Common/parallel_k2.hpp>
+#include <Common/parallel_tempering.hpp>
+#include <Common/thread_pool.hpp>
 
 std::size_t const iteration_num = 10; // 10
 
+// ƑXRA̓x̐: bn::adtree() / bn::column_counter(s𑖍)
+using FamilyCounter = bn::adtree;
+using FamilyScore = bn::evaluation::mdl_family_score<FamilyCounter>;
+
+// FamilyCounter(leaf_thresholdmemory_limitbn::adtree̐ݒŁCbn::column_counterł͎gȂ)
+inline bn::adtree make_family_counter(
+    bn::sample_table const& table, std::size_t const leaf_threshold, std::size_t const memory_limit, bn::adtree const*
+    )
+{
+    return bn::adtree(table, leaf_threshold, 1 << 20, memory_limit);
+}
+
+inline bn::column_counter make_family_counter(
+    bn::sample_table const& table, std::size_t const, std::size_t const, bn::column_counter const*
+    )
+{
+    return bn::column_counter(table);
+}
+
+// CůwK̕]
+// bn::evaluation::mdlD--cached-evaluationw莞͉ƑXRÃLbV
+// CachedEvaluation(lbn::evaluation::mdlƓ`)g
+// lv邱Ƃ͊wK̑Ocheck_evaluationŊm߁CvȂbn::evaluation::mdlɖ߂
 using EvaluationAlgorithm = bn::evaluation::mdl;
+using CachedEvaluation = bn::evaluation::cached_evaluation<FamilyScore>;
+
+// CůwKɓnsampler(ǂ̕]łg)
+// CachedEvaluationsampler̎LbV̂ŁCwKreset_cacheŐVLbVpӂC
+// wK̊ԂLearnerSampler::scopeŊwKĂԃXbhɌѕt
+// ̓CůwK󂯎sampler𕡐CĂ񂾃Xbhł̂܂ܕ]֓nƂɈ˂Ă
+// (Cu͕ۏ؂ĂȂDOcached_evaluationO𓊂C̊wǨʂ͓Ȃ)
+using LearnerSampler = bn::evaluation::caching_sampler<FamilyScore>;
+
+// CůwK1񕪂̍Əꏊ
+// tOtƓEl̐̒_ʂɍC̒_ŃTvǂݍsamplerƑgɂ
+// wKCPTsampler֏łCɑ鑼̊wKɂ͉eȂ
+// bn::sampler͓ǂݍ񂾒_ɌѕtCwK̒_CPT֏ނ̂ŃXbhԂŋLłȂ
+// ̂ߊecontextTvt@CŜ̕(context̐ɔႷ)
+// context̐--library-sampler(w肪Ȃauto_library_sampler_num)ŗ}
+struct learner_context {
+    bn::graph_t graph;
+    LearnerSampler sampler;
+};
+
+// ɑ点郉CůwK̐̊l
+// RAƂCTv̍̕vmemory_limitoCgɎ܂邾ɂ(Œ1)
+// eLXg̒l1(Ƌ؂2byteȏ)sampler͐Ŏ̂ŁC1̓t@C̑傫4{ڈƂ
+inline std::size_t auto_library_sampler_num(std::size_t const memory_limit, std::string const& sample_path)
+{
+    std::ifstream ifs(sample_path, std::ios::binary | std::ios::ate);
+    auto const file_size = ifs ? static_cast<std::uint64_t>(ifs.tellg()) : 0;
+    auto const copy_size = std::max<std::uint64_t>(1, file_size * 4);
+
+    auto const core_num = bn::thread_pool::default_thread_num();
+    auto const fit_num = static_cast<std::size_t>(std::min<std::uint64_t>(core_num, memory_limit / copy_size));
+    return std::max<std::size_t>(1, fit_num);
+}
 
+inline std::unique_ptr<learner_context> make_learner_context(bn::graph_t const& teacher_graph, std::string const& sample_path)
+{
+    std::unique_ptr<learner_context> context(new learner_context());
+    for(auto const& node : teacher_graph.vertex_list())
+    {
+        auto vertex = context->graph.add_vertex();
+        vertex->selectable_num = node->selectable_num;
+    }
+
+    context->sampler.set_filename(sample_path);
+    context->sampler.load_sample(context->graph.vertex_list());
+    return context;
+}
+
+// CachedEvaluationbn::evaluation::mdlƓlԂm߂
+// context̒_̕ӂ̖OtƋtOt̍\ŁCLbVlbn::evaluation::mdl̒lׁC
+// Ό덷StoleranceȉȂtrueԂ(ΐ̒萔Ⴆ΍ŏ̃OtŌo)
+inline bool check_evaluation(bn::graph_t const& teacher_graph, learner_context& context, FamilyCounter const& counter)
+{
+    double const tolerance = 1e-9;
+
+    auto const& teacher_nodes = teacher_graph.vertex_list();
+    auto const& nodes = context.graph.vertex_list();
+    std::unordered_map<bn::vertex_type, std::size_t> index;
+    for(std::size_t i = 0; i < teacher_nodes.size(); ++i) index[teacher_nodes[i]] = i;
+
+    auto empty_graph = context.graph;
+    empty_graph.erase_all_edge();
+    auto teacher_structure = empty_graph;
+    for(auto const& edge : teacher_graph.edge_list())
+        teacher_structure.add_edge(nodes[index.at(teacher_graph.source(edge))], nodes[index.at(teacher_graph.target(edge))]);
+
+    context.sampler.reset_cache(FamilyScore(counter));
+    LearnerSampler::scope const scope(&context.sampler);
+    for(auto const& graph : {empty_graph, teacher_structure})
+    {
+        // context̒_͊wKpȂ̂ŁCbn::evaluation::mdl_CPTǂł悢悤Ă
+        context.sampler.make_cpt(graph);
+        auto const library_score = bn::evaluation::mdl()(context.sampler, graph);
+        auto const cached_score = CachedEvaluation()(context.sampler, graph);
+        auto const error = std::abs(cached_score - library_score) / std::max(1.0, std::abs(library_score));
+        if(error > tolerance)
+        {
+            std::cout << "Checked Evaluation: the cached family score differs from bn::evaluation::mdl ("
+                      << cached_score << " vs " << library_score << ")" << std::endl;
+            return false;
+        }
+    }
+
+    std::cout << "Checked Evaluation: the cached family score matches bn::evaluation::mdl" << std::endl;
+    return true;
+}
+
+// thread_safe͋tOt̒_̂܂ܑ̊wKƓɑ点Ă悢(TvsamplerłȂx̍ǂ)
+// CůwK(bn::learning::*)͒_sampler֏܂ȂƂm߂Ȃ̂false
+// (wKlearner_context؂Cp̒_samplerő点)
+// exclusive͊wKg̃Xbhg
+// Ă񂾃XbhCPUԂł͑肸C̊wKƓɑ点ƎԂCPUԂ̂ŁC
+// ̊wKSďI1点CvZXŜCPUԂő
+// function̑3͎sԍ(0iteration_num-1)ŁCgwKs̎߂̂Ɏg
 struct algorithm_holder {
     std::string name;
-    std::function<double(bn::graph_t& graph, bn::sampler const& sampler)> function;
+    std::function<double(bn::graph_t& graph, bn::sampler const& sampler, std::size_t iteration)> function;
+    bool thread_safe;
+    bool exclusive;
 };
 
 namespace pruning_probability {
@@ -255,205 +384,315 @@ struct average_40_method {
 };
 }
 
-std::vector<algorithm_holder> const algorithms = {
-    {
-        "sshc_00",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+// CůwK(Evaluationbn::evaluation::mdlCachedEvaluation)
+template<class Evaluation>
+std::vector<algorithm_holder> make_library_algorithms()
+{
+    return {
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::previous_method> sshc(sampler);
-            return sshc(graph, 0.0);
-        }
-    },
-    {
-        "sshc_previous_10",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_00",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::previous_method> sshc(sampler);
+                return sshc(graph, 0.0);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::previous_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_previous_20",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_previous_10",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::previous_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::previous_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_previous_30",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_previous_20",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::previous_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::previous_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_same_10",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_previous_30",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::previous_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::same_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_same_20",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_same_10",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::same_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::same_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_same_30",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_same_20",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::same_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::same_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_rms60_10",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_same_30",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::same_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::rms_60_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_rms60_20",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_rms60_10",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::rms_60_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::rms_60_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_rms60_30",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_rms60_20",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::rms_60_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::rms_60_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_rms50_10",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_rms60_30",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::rms_60_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::rms_50_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_rms50_20",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_rms50_10",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::rms_50_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::rms_50_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_rms50_30",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_rms50_20",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::rms_50_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::rms_50_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_rms40_10",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_rms50_30",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::rms_50_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::rms_40_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_rms40_20",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_rms40_10",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::rms_40_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::rms_40_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_rms40_30",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_rms40_20",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::rms_40_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::rms_40_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_ave60_10",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_rms40_30",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::rms_40_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::average_60_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_ave60_20",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_ave60_10",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::average_60_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::average_60_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_ave60_30",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_ave60_20",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::average_60_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::average_60_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_ave50_10",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_ave60_30",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::average_60_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::average_50_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_ave50_20",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_ave50_10",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::average_50_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::average_50_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_ave50_30",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_ave50_20",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::average_50_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::average_50_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_ave40_10",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_ave50_30",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::average_50_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::average_40_method> sshc(sampler);
-            return sshc(graph, 0.3);
-        }
-    },
-    {
-        "sshc_ave40_20",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+            "sshc_ave40_10",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::average_40_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
+        {
+            "sshc_ave40_20",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::average_40_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
+        },
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::average_40_method> sshc(sampler);
-            return sshc(graph, 0.3);
+            "sshc_ave40_30",
+            [](bn::graph_t& graph, bn::sampler const& sampler, std::size_t)
+            {
+                bn::learning::stepwise_structure_hc<Evaluation, bn::learning::greedy, pruning_probability::average_40_method> sshc(sampler);
+                return sshc(graph, 0.3);
+            },
+            false,
+            false
         }
-    },
-    {
-        "sshc_ave40_30",
-        [](bn::graph_t& graph, bn::sampler const& sampler)
+    };
+}
+
+// Tv𒼐ڐASY(ƑXRALbV)
+// LbV͊wK1񖈂ɍ蒼(vԂɑǑʂ܂Ȃ)
+// x͓̍ǂނŁCwKʂ͊ẽOt̕̕ӂɂȂ̂ŁCɑ点Ă悢
+// ewK̓̃Xbhthread_num(0ȂSẴRA)
+// wK̃v[ő(thread_num1ȊÔƂ)exclusiveƂCPƂő点ăvZXŜCPUԂő
+// seed^ƁCgwK(tempering_cached, k2_restart_cached)iڂ̎sseed + iŏ
+// (ʂ̓Xbh⑖鏇Ɉ˂炸Čł)D^ȂΎsbn::make_engineŏ
+inline std::vector<algorithm_holder> make_counting_algorithms(
+    FamilyCounter const& counter, std::size_t const thread_num, boost::optional<std::uint32_t> const& seed
+    )
+{
+    return {
         {
-            bn::learning::stepwise_structure_hc<EvaluationAlgorithm, bn::learning::greedy, pruning_probability::average_40_method> sshc(sampler);
-            return sshc(graph, 0.3);
+            "greedy_cached",
+            [&counter, thread_num](bn::graph_t& graph, bn::sampler const&, std::size_t)
+            {
+                FamilyScore const score(counter);
+                bn::evaluation::family_score_cache<FamilyScore> cache(score);
+                bn::learning::cached_greedy<FamilyScore> greedy(cache, thread_num);
+                return greedy(graph);
+            },
+            true,
+            thread_num != 1
+        },
+        {
+            // ̐̓XbhɈ˂炸4{Ƃ(ʂ̓XbhɈ˂Ȃ)
+            "tempering_cached",
+            [&counter, thread_num, seed](bn::graph_t& graph, bn::sampler const&, std::size_t const iteration)
+            {
+                FamilyScore const score(counter);
+                bn::evaluation::family_score_cache<FamilyScore> cache(score);
+                bn::learning::parallel_tempering<FamilyScore> tempering(cache, thread_num);
+                if(seed) tempering.seed(static_cast<std::uint32_t>(seed.get() + iteration));
+                return tempering(graph, bn::learning::tempering_schedule{4, 0.5, 10.0, 5000, 40});
+            },
+            true,
+            thread_num != 1
+        },
+        {
+            // ͕Ȃ̂ŁC_ȏ20̂ŗǂ̂̂g(e3܂)
+            "k2_restart_cached",
+            [&counter, thread_num, seed](bn::graph_t& graph, bn::sampler const&, std::size_t const iteration)
+            {
+                FamilyScore const score(counter);
+                bn::evaluation::family_score_cache<FamilyScore> cache(score);
+                bn::learning::parallel_k2<FamilyScore> k2(cache, 3, thread_num);
+                if(seed) k2.seed(static_cast<std::uint32_t>(seed.get() + iteration));
+                return k2.random_restart(graph, 20);
+            },
+            true,
+            thread_num != 1
         }
-    }
-};
+    };
+}
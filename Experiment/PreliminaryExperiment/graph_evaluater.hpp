@@ -1,12 +1,18 @@
 #ifndef PRE_EXP_GRAPH_EVALUATER_HPP
 #define PRE_EXP_GRAPH_EVALUATER_HPP
 
+#include <tuple>
+#include <vector>
 #include <bayesian/graph.hpp>
+#include <Common/graph_diff.hpp>
 
 std::size_t count_disappeared_link(bn::graph_t const& teacher, bn::graph_t const& target);
 std::size_t count_appeared_link(bn::graph_t const& teacher, bn::graph_t const& target);
 std::size_t count_reversed_link(bn::graph_t const& teacher, bn::graph_t const& target);
 
+// N̑ݏʂ̘a - N̑ݏʂ̘a
+// mi_weight͑ݏʂ̃Xg1xĎg
+double distance(bn::graph_t const& teacher, bn::graph_t const& graph, bn::edge_weight const& mi_weight);
 double distance(bn::graph_t const& teacher, bn::graph_t const& graph, std::vector<std::tuple<bn::vertex_type, bn::vertex_type, double>> const& mi_list);
 
 #endif
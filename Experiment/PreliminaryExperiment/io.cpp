@@ -10,11 +10,11 @@
 #include <boost/program_options/variables_map.hpp>
 #include <boost/program_options/parsers.hpp>
 
-#include <bayesian/serializer/bif.hpp>
 #include <bayesian/serializer/dsc.hpp>
+#include <Common/graph_snapshot.hpp>
 #include "io.hpp"
 
-std::tuple<std::string, std::string, std::string, std::string> process_command_line(int argc, char* argv[])
+std::tuple<std::string, std::string, std::string, std::string, std::size_t, std::size_t, library_option, count_index_option, std::vector<std::string>, bool, boost::optional<std::uint32_t>> process_command_line(int argc, char* argv[])
 {
     boost::program_options::options_description opt("Option");
     opt.add_options()
@@ -22,7 +22,16 @@ std::tuple<std::string, std::string, std::string, std::string> process_command_l
         ("network,n", boost::program_options::value<std::string>(), "Network Path")
         ("sample,s",  boost::program_options::value<std::string>(), "Sample Path")
         ("milist,m",  boost::program_options::value<std::string>(), "MI List Path")
-        ("output,o",  boost::program_options::value<std::string>(), "Output Directory");
+        ("output,o",  boost::program_options::value<std::string>(), "Output Directory")
+        ("thread,t",  boost::program_options::value<std::size_t>(), "Learning Thread Num (default: all cores)")
+        ("learner-thread", boost::program_options::value<std::size_t>(), "Thread Num Inside Each Counting Learner (0: all cores, default: 1)")
+        ("library-sampler", boost::program_options::value<std::size_t>(), "Library Learners Run At Once (default: all cores, bounded by --library-memory). Each loads its own copy of the text sample, estimated at 4x the sample file size, so memory grows linearly with this number")
+        ("library-memory",  boost::program_options::value<std::size_t>(), "Memory Budget For The Library Learners' Sample Copies [MB] (default: 4096); only used when --library-sampler is not given")
+        ("leaf-threshold", boost::program_options::value<std::size_t>(), "Count Index Leaf-List Rows (default: 64)")
+        ("index-memory",   boost::program_options::value<std::size_t>(), "Count Index Memory Limit [MB] (default: 256)")
+        ("algorithm,a", boost::program_options::value<std::vector<std::string>>()->multitoken(), "Learners To Run (default: all). Binary sample files need counting learners only (greedy_cached, tempering_cached, ...)")
+        ("cached-evaluation", "Opt-in: library learners score through the family score cache instead of bn::evaluation::mdl (checked against mdl at startup; falls back to mdl on mismatch)")
+        ("seed", boost::program_options::value<std::uint32_t>(), "Random Seed For tempering_cached and k2_restart_cached; iteration i uses seed + i (default: random device)");
 
 	boost::program_options::variables_map vm;
 	store(parse_command_line(argc, argv, opt), vm);
@@ -41,21 +50,35 @@ std::tuple<std::string, std::string, std::string, std::string> process_command_l
         std::exit(0);
     }
 
-    return std::make_tuple(vm["network"].as<std::string>(), vm["sample"].as<std::string>(), vm["milist"].as<std::string>(), vm["output"].as<std::string>());
+    if(vm.count("library-sampler") && vm["library-sampler"].as<std::size_t>() == 0)
+        throw std::runtime_error("error: --library-sampler must be positive");
+
+    return std::make_tuple(
+        vm["network"].as<std::string>(),
+        vm["sample"].as<std::string>(),
+        vm["milist"].as<std::string>(),
+        vm["output"].as<std::string>(),
+        vm.count("thread") ? vm["thread"].as<std::size_t>() : 0,
+        vm.count("learner-thread") ? vm["learner-thread"].as<std::size_t>() : 1,
+        library_option{
+            vm.count("library-sampler") ? vm["library-sampler"].as<std::size_t>() : 0,
+            (vm.count("library-memory") ? vm["library-memory"].as<std::size_t>() : 4096) << 20
+            },
+        count_index_option{
+            vm.count("leaf-threshold") ? vm["leaf-threshold"].as<std::size_t>() : 64,
+            (vm.count("index-memory") ? vm["index-memory"].as<std::size_t>() : 256) << 20
+            },
+        vm.count("algorithm") ? vm["algorithm"].as<std::vector<std::string>>() : std::vector<std::string>(),
+        vm.count("cached-evaluation") != 0,
+        vm.count("seed") ? boost::make_optional(vm["seed"].as<std::uint32_t>()) : boost::none
+        );
 }
 
 std::tuple<bn::graph_t, bn::database_t> load_auto_graph(boost::filesystem::path const& file)
 {
-    // JđSǂݍ
-    boost::filesystem::ifstream ifs(file);
-    std::string graph_data{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
-
-    if(file.extension() == ".bif")
-    {
-        bn::serializer::bif bif;
-        auto&& graph = bif.parse(graph_data.cbegin(), graph_data.cend());
-        return graph;
-    }
+    // BIFƃXibvVbg̓}bvĒډ͂
+    if(file.extension() == ".bif" || file.extension() == ".bnsnap")
+        return bn::serializer::load_graph(file.string());
     else if(file.extension() == ".dsc")
         throw std::runtime_error("error: Deprecation of DSC file (" + file.string() + ")");
     else
@@ -1,15 +1,30 @@
 #ifndef PRE_EXP_IO_HPP
 #define PRE_EXP_IO_HPP
 
+#include <cstdint>
 #include <string>
 #include <tuple>
 #include <vector>
+#include <boost/algorithm/string.hpp>
 #include <boost/timer/timer.hpp>
 #include <boost/filesystem/path.hpp>
+#include <boost/optional.hpp>
 #include <bayesian/graph.hpp>
 #include "algorithms.hpp"
 
-std::tuple<std::string, std::string, std::string, std::string> process_command_line(int argc, char* argv[]);
+// CůwK𓯎ɑ点鐔̐ݒ
+struct library_option {
+    std::size_t sampler_num;  // 0ȂRAmemory_limit猈߂
+    std::size_t memory_limit; // oCg(Tv̍̕v̖ڈ)
+};
+
+// x(bn::adtree)̐ݒ
+struct count_index_option {
+    std::size_t leaf_threshold;
+    std::size_t memory_limit; // oCg
+};
+
+std::tuple<std::string, std::string, std::string, std::string, std::size_t, std::size_t, library_option, count_index_option, std::vector<std::string>, bool, boost::optional<std::uint32_t>> process_command_line(int argc, char* argv[]);
 
 std::tuple<bn::graph_t, bn::database_t> load_auto_graph(boost::filesystem::path const& file);
 
@@ -62,6 +77,7 @@ void write_result(
     std::vector<result_t> const& all_result
     )
 {
+    // Time͊wKg[UCPU(learning()Q)
     ost << ",Score,Time [s],MAE ,Disappeared Link,Appeared Link,Reversed Link,Change Mutual Information\n";
 
     double score = 0.0;
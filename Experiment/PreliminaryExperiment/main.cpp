@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <future>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <random>
 
 #define BOOST_SPIRIT_INCLUDE_PHOENIX
@@ -13,6 +17,9 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <Common/resource_pool.hpp>
+#include <Common/sample_table.hpp>
+#include <Common/thread_pool.hpp>
 
 #include "io.hpp"
 #include "graph_evaluater.hpp"
@@ -24,7 +31,28 @@ int main(int argc, char* argv[])
 {
     auto engine = bn::make_engine<std::mt19937>();
     boost::filesystem::path network_path, sample_path, milist_path, output_path;
-    std::tie(network_path, sample_path, milist_path, output_path) = process_command_line(argc, argv);
+    std::size_t thread_num, learner_thread_num;
+    library_option library;
+    count_index_option index_option;
+    std::vector<std::string> algorithm_names;
+    bool cached_evaluation;
+    boost::optional<std::uint32_t> seed;
+    std::tie(network_path, sample_path, milist_path, output_path, thread_num, learner_thread_num, library, index_option, algorithm_names, cached_evaluation, seed) = process_command_line(argc, argv);
+
+    // --algorithmőI΂ꂽwK̂ݑ点(w肪ȂΑS)
+    auto const selected = [&algorithm_names](algorithm_holder const& algorithm)
+    {
+        return algorithm_names.empty() || std::find(algorithm_names.begin(), algorithm_names.end(), algorithm.name) != algorithm_names.end();
+    };
+
+    // CůwKbn::samplerŃTvǂނ̂ŁCeLXg`̃TvKv
+    // (vɂwK͑Sthread_safeŁCx̍ǂ܂Ȃ̂ŃoCi`ł悢)
+    // OɊm߂
+    auto library_algorithms = make_library_algorithms<EvaluationAlgorithm>();
+    bool const library_learning = std::any_of(
+        library_algorithms.begin(), library_algorithms.end(), [&selected](algorithm_holder const& algorithm){ return selected(algorithm) && !algorithm.thread_safe; });
+    if(library_learning && bn::binary_sample::is_binary_file(sample_path.string()))
+        throw std::runtime_error("error: " + sample_path.string() + " is a binary sample file; the library learners need a text sample file (select counting learners only with --algorithm)");
 
     // Otǂݍ
     std::cout << "Load Graph..." << std::endl;
@@ -32,37 +60,129 @@ int main(int argc, char* argv[])
     bn::database_t teacher_database;
     std::tie(teacher_graph, teacher_database) = load_auto_graph(network_path);
 
-    // Tvɓǂݍ܂
-    // ɋtOtɁCقǏsamplingf[^pCPTč쐬
-    std::cout << "Load Sample..." << std::endl;
-    bn::sampler sampler;
-    sampler.set_filename(sample_path.string());
-    sampler.load_sample(teacher_graph.vertex_list());
-    sampler.make_cpt(teacher_graph);
+    // ƑXRA𐔂邽߂̓x̍
+    // Tv͂1xǂݍ݁CvɂwK͑SĂ̍ǂނŋL
+    std::cout << "Build Count Index..." << std::endl;
+    auto const counter = [&]
+    {
+        bn::sample_table table;
+        table.load(sample_path.string(), teacher_graph.vertex_list());
+        return make_family_counter(
+            table, index_option.leaf_threshold, index_option.memory_limit, static_cast<FamilyCounter const*>(nullptr));
+    }();
+
+    // CůwK1񕪂̍Əꏊ(_ƃTvǂݍsampler)
+    // learner_context͂ꂼTv̕̂ŁC鐔--threadłȂ--library-samplerŌ܂
+    bn::resource_pool<learner_context> contexts(
+        [&teacher_graph, &sample_path]
+        {
+            return make_learner_context(teacher_graph, sample_path.string());
+        });
+
+    // --cached-evaluationw莞́CŏcontextŒlbn::evaluation::mdlƈv邱Ƃm߂Ăg
+    // (context͂̂܂܊wKɎg)DvȂΌxbn::evaluation::mdlŊwK
+    cached_evaluation = cached_evaluation && library_learning;
+    if(cached_evaluation)
+    {
+        auto const context = contexts.acquire();
+        if(check_evaluation(teacher_graph, *context, counter))
+        {
+            library_algorithms = make_library_algorithms<CachedEvaluation>();
+        }
+        else
+        {
+            std::cout << "Warning: --cached-evaluation is ignored; the library learners use bn::evaluation::mdl" << std::endl;
+            cached_evaluation = false;
+        }
+    }
+
+    std::vector<algorithm_holder> all_algorithms;
+    auto const counting_algorithms = make_counting_algorithms(counter, learner_thread_num, seed);
+    std::copy_if(library_algorithms.begin(), library_algorithms.end(), std::back_inserter(all_algorithms), selected);
+    std::copy_if(counting_algorithms.begin(), counting_algorithms.end(), std::back_inserter(all_algorithms), selected);
+    for(auto const& name : algorithm_names)
+    {
+        if(std::none_of(all_algorithms.begin(), all_algorithms.end(), [&name](algorithm_holder const& algorithm){ return algorithm.name == name; }))
+            throw std::runtime_error("error: Unknown algorithm " + name);
+    }
 
     // ݏʃXgǂݍ
     std::cout << "Load MI List..." << std::endl;
     boost::filesystem::ifstream mi_ifs(milist_path);
     auto const mi_list = mi_list_load(mi_ifs, teacher_graph.vertex_list(), teacher_database);
     mi_ifs.close();
+    bn::edge_weight const mi_weight(mi_list);
 
     // Run!
-    for(auto const& algorithm : algorithms)
+    // (ASY, s) ̍\wKXbhv[ŕɉ
+    // thread_safeȊwK͋tOt̕(_͋L)n܂CTv͓x̍ǂ
+    // (sampler͓ǂ܂Ȃ̂ŁCTvǂݍłȂ̂̂n)
+    // thread_safełȂwK(Cû)library_sampler_num̃Xbh̕ʂ̃v[őC
+    // 󂢂Ălearner_context؂āC̒_samplerő
+    // exclusiveȊwK͎̃XbhĝŁCv[̊wKSďIɂ̃Xbh1点
+    bn::sampler const no_sample;
+
+    bn::thread_pool pool(thread_num);
+    std::unique_ptr<bn::thread_pool> library_pool;
+    if(library_learning)
+    {
+        auto const library_sampler_num = library.sampler_num != 0 ? library.sampler_num : auto_library_sampler_num(library.memory_limit, sample_path.string());
+        std::cout << "Library Learners At Once: " << library_sampler_num << " (each holds its own copy of the sample)" << std::endl;
+        library_pool.reset(new bn::thread_pool(library_sampler_num));
+    }
+    std::vector<std::vector<std::future<result_t>>> learned(all_algorithms.size());
+    std::vector<std::shared_ptr<std::packaged_task<result_t()>>> exclusive_tasks;
+    for(std::size_t a = 0; a < all_algorithms.size(); ++a)
+    {
+        for(std::size_t i = 0; i < iteration_num; ++i)
+        {
+            auto const task = std::make_shared<std::packaged_task<result_t()>>(
+                [&teacher_graph, &no_sample, &counter, &all_algorithms, &mi_weight, &contexts, cached_evaluation, a, i]
+                {
+                    auto const& algorithm = all_algorithms[a];
+
+                    // \wK
+                    // wK̃Ot̒_͋tOtƋLĂ̂ŁC_CPTɂ͏܂Ȃ
+                    // (p[^Kvȏꍇbn::parameter_cacheŕʂɎ)
+                    auto result = [&]() -> result_t
+                    {
+                        if(algorithm.thread_safe)
+                            return learning(teacher_graph, teacher_graph, no_sample, algorithm.function, i, algorithm.exclusive);
+
+                        // CachedEvaluationŊwKȂCwKɐVLbVpӂẴXbhɌѕt
+                        auto const context = contexts.acquire();
+                        if(cached_evaluation) context->sampler.reset_cache(FamilyScore(counter));
+                        LearnerSampler::scope const scope(cached_evaluation ? &context->sampler : nullptr);
+                        return learning(teacher_graph, context->graph, context->sampler, algorithm.function, i, algorithm.exclusive);
+                    }();
+
+                    // MI Change
+                    result.change_mi = distance(teacher_graph, result.graph, mi_weight);
+                    return result;
+                });
+            learned[a].push_back(task->get_future());
+            if(all_algorithms[a].exclusive) exclusive_tasks.push_back(task);
+            else if(!all_algorithms[a].thread_safe) library_pool->submit([task]{ (*task)(); });
+            else pool.submit([task]{ (*task)(); });
+        }
+    }
+
+    // wK̗Ofuture󂯎̂ŁCwait͓Ȃ
+    pool.wait();
+    if(library_pool) library_pool->wait();
+    for(auto const& task : exclusive_tasks) (*task)();
+
+    // ʂ̓ASYEsɎ󂯎ďo
+    for(std::size_t a = 0; a < all_algorithms.size(); ++a)
     {
-        std::string const algorithm_name = algorithm.name;
+        std::string const algorithm_name = all_algorithms[a].name;
         std::cout << "---------- " << algorithm_name << " ----------" << std::endl;
 
         std::cout << "Learning..." << std::endl;
         std::vector<result_t> all_result;
         for(std::size_t i = 0; i < iteration_num; ++i)
         {
-            // \wK
-            auto result = learning(teacher_graph, sampler, algorithm.function);
-            sampler.make_cpt(result.graph); // CPT쐬
-
-            // MI Change
-            result.change_mi = distance(teacher_graph, result.graph, mi_list);
-
+            auto result = learned[a][i].get();
             std::cout << "Learned: " << result.time << " (s)" << std::endl;
             all_result.push_back(std::move(result));
         }
@@ -1,5 +1,8 @@
+#include <exception>
 #include <iostream>
 #include <fstream>
+#include <thread>
+#include <boost/optional.hpp>
 
 #define DEBUG_LOG_ 1
 #define BOOST_SPIRIT_INCLUDE_PHOENIX
@@ -9,15 +12,29 @@
 #include <boost/program_options/parsers.hpp>
 
 #include <bayesian/graph.hpp>
-#include <bayesian/serializer/bif.hpp>
-#include <bayesian/inference/likelihood_weighting.hpp>
+#include <Common/bounded_queue.hpp>
+#include <Common/compiled_network.hpp>
+#include <Common/graph_snapshot.hpp>
+#include <Common/parallel_likelihood_weighting.hpp>
+#include <Common/sample_table.hpp>
 
 struct command_line_t {
     std::string const output;
     std::string const network;
     std::size_t const sample_size;
+    std::size_t const thread_num;
+    boost::optional<std::uint32_t> const seed;
+    std::size_t const block_size;
+    bool const binary;
+    std::size_t const chunk_size;
 };
 
+using samples_type = std::vector<bn::inference::parallel_likelihood_weighting::sample_type>;
+
+// xɐEoTv̊lƁCo҂ɂł`N
+std::size_t const DEFAULT_CHUNK_SIZE = 1000000;
+std::size_t const QUEUE_CAPACITY = 2;
+
 command_line_t process_command_line(int argc, char* argv[])
 {
     boost::program_options::options_description opt("Option");
@@ -25,7 +42,12 @@ command_line_t process_command_line(int argc, char* argv[])
         ("help,h",                                                  "Show this help")
         ("output,o",  boost::program_options::value<std::string>(), "Sample Output Path    [required]")
         ("network,n", boost::program_options::value<std::string>(), "Network Path          [required]")
-        ("num,i",     boost::program_options::value<std::string>(), "Generating Sample Num [required]");
+        ("num,i",     boost::program_options::value<std::string>(), "Generating Sample Num [required]")
+        ("thread,t",  boost::program_options::value<std::size_t>(), "Sampling Thread Num   [optional]")
+        ("seed",      boost::program_options::value<std::uint32_t>(), "Random Seed           [optional]")
+        ("batch,b",   boost::program_options::value<std::size_t>(), "Sampling Block Size   [optional]")
+        ("binary",                                                  "Write Binary Format   [optional]")
+        ("chunk,c",   boost::program_options::value<std::size_t>(), "Samples per Chunk     [optional]");
 
 	boost::program_options::variables_map vm;
 	store(parse_command_line(argc, argv, opt), vm);
@@ -45,51 +67,158 @@ command_line_t process_command_line(int argc, char* argv[])
     }
 
     std::size_t const num = std::stoull(vm["num"].as<std::string>());
+    std::size_t const thread_num = vm.count("thread") ? vm["thread"].as<std::size_t>() : 0;
+    auto const seed = vm.count("seed") ? boost::make_optional(vm["seed"].as<std::uint32_t>()) : boost::none;
+    std::size_t const block_size = vm.count("batch") ? vm["batch"].as<std::size_t>() : 0;
+    std::size_t const chunk_size = vm.count("chunk") ? vm["chunk"].as<std::size_t>() : DEFAULT_CHUNK_SIZE;
+    if(chunk_size == 0)
+        throw std::runtime_error("error: --chunk must be positive");
+    if(vm.count("batch") && block_size == 0)
+        throw std::runtime_error("error: --batch must be positive");
+
+    return { vm["output"].as<std::string>(), vm["network"].as<std::string>(), num, thread_num, seed, block_size, vm.count("binary") != 0, chunk_size };
+}
+
+// 񕉐10ibuffer̖ɒǉ
+void append_number(std::string& buffer, std::size_t value)
+{
+    char digits[20];
+    std::size_t length = 0;
+    do
+    {
+        digits[length++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while(value != 0);
 
-    return { vm["output"].as<std::string>(), vm["network"].as<std::string>(), num };
+    while(length != 0) buffer.push_back(digits[--length]);
 }
 
+// Tv "num v0 v1 ..." ̌`Ŏg񂵂bufferɐ`Ă珑o
 template<class OutputStream>
-void write_sample(OutputStream& ost, std::vector<bn::vertex_type> const& vertex_list, std::vector<bn::inference::likelihood_weighting::element_type> const& samples)
+void write_sample(OutputStream& ost, std::string& buffer, samples_type const& samples)
 {
+    buffer.clear();
     for(auto const& data : samples)
     {
-        // data̗
-        std::ostringstream oss;
-        for(std::size_t i = 0; i < data.select.size(); ++i)
+        // data_numƂďo
+        append_number(buffer, data.num);
+        for(auto const value : data.select)
         {
-            if(i != 0) oss << " ";
-            oss << data.select[i];
+            buffer.push_back(' ');
+            append_number(buffer, value);
         }
-        oss << "\n";
-
-        // data_numƂďo
-        ost << data.num << " " << oss.str();
+        buffer.push_back('\n');
     }
+
+    ost.write(buffer.data(), buffer.size());
 }
 
+// oXbhCXR[v𔲂ƂɕKL[join
+// o̗O͕ۑĂCjoinrethrowŌĂяõXbh֓
+class sample_writer {
+public:
+    template<class Func>
+    sample_writer(bn::bounded_queue<samples_type>& queue, Func func)
+        : queue_(queue)
+    {
+        thread_ = std::thread(
+            [this, func]
+            {
+                try
+                {
+                    func();
+                }
+                catch(...)
+                {
+                    error_ = std::current_exception();
+                }
+
+                // o~߂琶push҂Ȃ
+                queue_.close();
+            });
+    }
+
+    ~sample_writer()
+    {
+        if(thread_.joinable())
+        {
+            queue_.close();
+            thread_.join();
+        }
+    }
+
+    sample_writer(sample_writer const&) = delete;
+    sample_writer& operator=(sample_writer const&) = delete;
+
+    // coďI҂Co̗OΓ
+    void finish()
+    {
+        queue_.close();
+        thread_.join();
+        if(error_) std::rethrow_exception(error_);
+    }
+
+private:
+    bn::bounded_queue<samples_type>& queue_;
+    std::thread thread_;
+    std::exception_ptr error_;
+};
+
 int main(int argc, char* argv[])
 {
     // R}hCp[X
     auto const command_line = process_command_line(argc, argv);
 
-    // Ott@CJgraph_dataɓ
-    std::ifstream ifs(command_line.network);
-    std::string const graph_data{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
-    ifs.close();
-    std::cout << "Loaded Graph: Length = " << graph_data.size() << std::endl;
-
-    // graph_dataOtp[X
-    auto const graph = std::get<0>(bn::serializer::bif().parse(graph_data.cbegin(), graph_data.cend()));
+    // Ott@Cǂݍ(.bnsnapȂXibvVbgCȊOBIF)
+    auto const graph = std::get<0>(bn::serializer::load_graph(command_line.network));
     auto const& vertex_list = graph.vertex_list();
     std::cout << "Parsed Graph: Num of Node = " << vertex_list.size() << std::endl;
 
     // Tvmake
-    bn::inference::likelihood_weighting lw(graph);
-    auto const samples = lw.make_samples({}, command_line.sample_size);
-
-    // Tv̏o
-    std::ofstream ofs(command_line.output);
-    write_sample(ofs, vertex_list, samples);
-    ofs.close();
+    // l̑g̓`Nł݂̂܂Ƃ߂
+    bn::inference::parallel_likelihood_weighting lw(bn::compiled_network(graph), command_line.thread_num);
+    if(command_line.seed) lw.seed(command_line.seed.get());
+
+    // Tv̏o̓`NɕʃXbhōs
+    // ̓L[󂭂܂ő҂̂ŁCgpʂ--numɂ炸
+    bn::bounded_queue<samples_type> queue(QUEUE_CAPACITY);
+    sample_writer writer_thread(queue,
+        [&command_line, &vertex_list, &queue]
+        {
+            samples_type samples;
+            if(command_line.binary)
+            {
+                bn::binary_sample::writer writer(command_line.output, vertex_list);
+                while(queue.pop(samples)) writer.write_block(samples);
+                writer.close();
+            }
+            else
+            {
+                std::ofstream ofs(command_line.output);
+                if(!ofs) throw std::runtime_error("error: Cannot open " + command_line.output);
+
+                std::string buffer;
+                while(queue.pop(samples))
+                {
+                    write_sample(ofs, buffer, samples);
+                    if(!ofs) throw std::runtime_error("error: Failed to write " + command_line.output);
+                }
+                ofs.close();
+                if(!ofs) throw std::runtime_error("error: Failed to write " + command_line.output);
+            }
+        });
+
+    for(std::size_t done = 0; done < command_line.sample_size; done += command_line.chunk_size)
+    {
+        auto const size = std::min(command_line.chunk_size, command_line.sample_size - done);
+        auto const pushed = queue.push(
+            command_line.block_size != 0
+                ? lw.make_samples_batch(size, command_line.block_size)
+                : lw.make_samples({}, size)
+            );
+
+        // o~܂(OfinishŎ󂯎)
+        if(!pushed) break;
+    }
+    writer_thread.finish();
 }
@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#define BOOST_SPIRIT_INCLUDE_PHOENIX
+#include <boost/phoenix/phoenix.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <boost/program_options/parsers.hpp>
+
+#include <bayesian/graph.hpp>
+#include <bayesian/serializer/bif.hpp>
+#include <Common/bif_reader.hpp>
+#include <Common/graph_compare.hpp>
+#include <Common/graph_snapshot.hpp>
+#include <Common/parallel_likelihood_weighting.hpp>
+#include <Common/reachability_index.hpp>
+#include <Common/variable_elimination.hpp>
+
+// O̎CufpȎƓʂԂm߂
+// ͑SČŒ̃V[ĥŁCʂ͖񓯂ɂȂ(ႢΏIR[hŒm点)
+//   bif       : bif_readerbn::serializer::bif̓ǂݍ݌
+//   snapshot  : graph_snapshot̏oƓǍ̉
+//   ve        : variable_eliminationƑSĂ̒l̑g̗񋓂ɂ錵Ȏ㕪z
+//   lw        : parallel_likelihood_weightingvariable_elimination(TvŌ܂덷܂)
+//   reach     : reachability_indexƁCӂ̃_ȒǉE폜̌DFS
+// _̊mF͑gݍ݂̏ȃlbg[NōsD--network^bifsnapshot͂̃t@Cłs
+
+// gݍ݂̏ȃlbg[N(l̐̈Ⴄ_CЂ`̍C2̐e_܂)
+char const toy_network[] =
+    "network toy {\n"
+    "}\n"
+    "variable A {\n"
+    "  type discrete [ 3 ] { a0, a1, a2 };\n"
+    "}\n"
+    "variable B {\n"
+    "  type discrete [ 2 ] { b0, b1 };\n"
+    "}\n"
+    "variable C {\n"
+    "  type discrete [ 2 ] { c0, c1 };\n"
+    "}\n"
+    "variable D {\n"
+    "  type discrete [ 3 ] { d0, d1, d2 };\n"
+    "}\n"
+    "variable E {\n"
+    "  type discrete [ 2 ] { e0, e1 };\n"
+    "}\n"
+    "probability ( A ) {\n"
+    "  table 0.2, 0.5, 0.3;\n"
+    "}\n"
+    "probability ( B | A ) {\n"
+    "  (a0) 0.9, 0.1;\n"
+    "  (a1) 0.4, 0.6;\n"
+    "  (a2) 0.25, 0.75;\n"
+    "}\n"
+    "probability ( C | A ) {\n"
+    "  (a0) 0.3, 0.7;\n"
+    "  (a1) 0.8, 0.2;\n"
+    "  (a2) 0.5, 0.5;\n"
+    "}\n"
+    "probability ( D | B, C ) {\n"
+    "  (b0, c0) 0.7, 0.2, 0.1;\n"
+    "  (b0, c1) 0.1, 0.6, 0.3;\n"
+    "  (b1, c0) 0.2, 0.2, 0.6;\n"
+    "  (b1, c1) 0.05, 0.15, 0.8;\n"
+    "}\n"
+    "probability ( E | D ) {\n"
+    "  (d0) 0.95, 0.05;\n"
+    "  (d1) 0.5, 0.5;\n"
+    "  (d2) 0.1, 0.9;\n"
+    "}\n";
+
+struct command_line_t {
+    std::vector<std::string> const networks;
+};
+
+command_line_t process_command_line(int argc, char* argv[])
+{
+    boost::program_options::options_description opt("Option");
+    opt.add_options()
+        ("help,h",                                                                               "Show this help")
+        ("network,n", boost::program_options::value<std::vector<std::string>>()->multitoken(), "Networks (.bif or .bnsnap) to check the parsers and the snapshot round trip on [optional]");
+
+	boost::program_options::variables_map vm;
+	store(parse_command_line(argc, argv, opt), vm);
+	notify(vm);
+
+    if(vm.count("help"))
+    {
+        std::cout << opt << std::endl;
+        std::exit(0);
+    }
+
+    return { vm.count("network") ? vm["network"].as<std::vector<std::string>>() : std::vector<std::string>() };
+}
+
+// mF̌ʂ\Đ
+class checker {
+public:
+    // check͈Ⴂ̐Ԃ(Ȃ󕶎)DOႢƂĈ
+    void operator()(std::string const& name, std::function<std::string()> const& check)
+    {
+        std::string difference;
+        try
+        {
+            difference = check();
+        }
+        catch(std::exception const& e)
+        {
+            difference = e.what();
+        }
+
+        if(difference.empty())
+        {
+            std::cout << "[OK] " << name << std::endl;
+        }
+        else
+        {
+            std::cout << "[NG] " << name << ": " << difference << std::endl;
+            ++failed_;
+        }
+    }
+
+    std::size_t failed() const
+    {
+        return failed_;
+    }
+
+private:
+    std::size_t failed_ = 0;
+};
+
+// ꎞt@CփXibvVbgoēǂݒCƔׂ(mSɈv邱)
+std::string snapshot_round_trip(std::tuple<bn::graph_t, bn::database_t> const& source)
+{
+    auto const path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%-%%%%.bnsnap");
+    bn::serializer::graph_snapshot().save(path.string(), std::get<0>(source), std::get<1>(source));
+
+    std::string difference;
+    try
+    {
+        difference = bn::serializer::graph_difference(source, bn::serializer::graph_snapshot().load(path.string()), 0.0);
+    }
+    catch(...)
+    {
+        boost::system::error_code ec;
+        boost::filesystem::remove(path, ec);
+        throw;
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::remove(path, ec);
+    return difference;
+}
+
+using evidence_type = std::unordered_map<bn::vertex_type, std::size_t>;
+using posterior_type = std::unordered_map<bn::vertex_type, std::vector<double>>;
+
+// SĂ̒l̑g̓m𒸓_CPT璼ڊ|āCevidencẻł̊e_̎㕪z߂
+posterior_type enumerate_posterior(bn::graph_t const& graph, evidence_type const& evidence)
+{
+    auto const& nodes = graph.vertex_list();
+    std::unordered_map<bn::vertex_type, std::size_t> index;
+    std::vector<std::vector<bn::vertex_type>> parents(nodes.size());
+    for(std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        index[nodes[i]] = i;
+        for(auto const& edge : graph.in_edges(nodes[i]))
+            parents[i].push_back(graph.source(edge));
+    }
+
+    posterior_type posterior;
+    for(auto const& node : nodes)
+        posterior[node].assign(node->selectable_num, 0.0);
+
+    std::vector<std::size_t> select(nodes.size(), 0);
+    while(true)
+    {
+        auto consistent = true;
+        for(auto const& observed : evidence)
+            consistent = consistent && select[index.at(observed.first)] == observed.second;
+
+        if(consistent)
+        {
+            double joint = 1.0;
+            for(std::size_t i = 0; i < nodes.size(); ++i)
+            {
+                evidence_type condition;
+                for(auto const& parent : parents[i])
+                    condition[parent] = select[index.at(parent)];
+                joint *= nodes[i]->cpt[condition][select[i]];
+            }
+
+            for(std::size_t i = 0; i < nodes.size(); ++i)
+                posterior[nodes[i]][select[i]] += joint;
+        }
+
+        // Ō̒_łς鏇Ɏ̑g֐i߂
+        std::size_t i = nodes.size();
+        while(i > 0 && ++select[i - 1] == nodes[i - 1]->selectable_num)
+            select[--i] = 0;
+        if(i == 0) break;
+    }
+
+    for(auto& distribution : posterior)
+    {
+        double total = 0.0;
+        for(auto const p : distribution.second) total += p;
+        if(total > 0.0)
+        {
+            for(auto& p : distribution.second) p /= total;
+        }
+    }
+    return posterior;
+}
+
+// SĂ̒_̎㕪zexpectedƔׂ(toleranceȉȂ瓯)
+template<class Posterior>
+std::string compare_posterior(
+    bn::graph_t const& graph, bn::database_t const& database, Posterior posterior, posterior_type const& expected, double const tolerance
+    )
+{
+    for(auto const& node : graph.vertex_list())
+    {
+        auto const actual = posterior(node);
+        auto const& answer = expected.at(node);
+        for(std::size_t value = 0; value < answer.size(); ++value)
+        {
+            if(!(std::abs(actual.at(value) - answer[value]) <= tolerance))
+            {
+                return "P(" + database.node_name.at(node->id) + " = " + std::to_string(value) + ") is "
+                    + std::to_string(actual.at(value)) + " but " + std::to_string(answer[value]);
+            }
+        }
+    }
+    return std::string();
+}
+
+// _̖Oƒl̔ԍ̑gEvidence
+evidence_type make_evidence(
+    bn::graph_t const& graph, bn::database_t const& database, std::vector<std::pair<std::string, std::size_t>> const& observed
+    )
+{
+    evidence_type evidence;
+    for(auto const& select : observed)
+    {
+        auto const& nodes = graph.vertex_list();
+        auto const it = std::find_if(nodes.begin(), nodes.end(),
+            [&database, &select](bn::vertex_type const& node){ return database.node_name.at(node->id) == select.first; });
+        if(it == nodes.end()) throw std::runtime_error("error: No node named " + select.first);
+        evidence[*it] = select.second;
+    }
+    return evidence;
+}
+
+// node_num_ɕӂ̒ǉE폜operation_num񃉃_ɍsC̓x
+// reachability_index̓B\ƕHאڃXgDFSƔׂ
+std::string reachability_against_dfs(std::size_t const node_num, std::size_t const operation_num, std::mt19937::result_type const seed)
+{
+    std::vector<std::vector<std::size_t>> children(node_num);
+
+    // ignore_fromignore_to̕ӂ͒H炸ɁCfromto֒邩
+    auto const dfs = [&children, node_num](std::size_t const from, std::size_t const to, std::size_t const ignore_from, std::size_t const ignore_to)
+    {
+        std::vector<char> visited(node_num, 0);
+        std::vector<std::size_t> stack(1, from);
+        while(!stack.empty())
+        {
+            auto const node = stack.back();
+            stack.pop_back();
+            for(auto const child : children[node])
+            {
+                if(node == ignore_from && child == ignore_to) continue;
+                if(child == to) return true;
+                if(!visited[child])
+                {
+                    visited[child] = 1;
+                    stack.push_back(child);
+                }
+            }
+        }
+        return false;
+    };
+
+    bn::reachability_index index(node_num);
+    std::mt19937 engine(seed);
+    std::uniform_int_distribution<std::size_t> pick(0, node_num - 1);
+    for(std::size_t operation = 0; operation < operation_num; ++operation)
+    {
+        auto const from = pick(engine);
+        auto const to = pick(engine);
+        if(from == to) continue;
+
+        auto const edge = std::find(children[from].begin(), children[from].end(), to);
+        auto const step = "operation " + std::to_string(operation) + " (" + std::to_string(from) + " -> " + std::to_string(to) + "): ";
+        if(edge != children[from].end())
+        {
+            if(index.reverse_makes_cycle(from, to) != dfs(from, to, from, to))
+                return step + "reverse_makes_cycle differs from DFS";
+
+            children[from].erase(edge);
+            index.erase_edge(from, to);
+        }
+        else
+        {
+            if(index.makes_cycle(from, to) != dfs(to, from, node_num, node_num))
+                return step + "makes_cycle differs from DFS";
+            if(index.makes_cycle(from, to)) continue;
+
+            children[from].push_back(to);
+            index.add_edge(from, to);
+        }
+
+        for(std::size_t lhs = 0; lhs < node_num; ++lhs)
+        {
+            for(std::size_t rhs = 0; rhs < node_num; ++rhs)
+            {
+                if(index.reachable(lhs, rhs) != dfs(lhs, rhs, node_num, node_num))
+                    return step + "reachable(" + std::to_string(lhs) + ", " + std::to_string(rhs) + ") differs from DFS";
+            }
+        }
+    }
+    return std::string();
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        // R}hCp[X
+        auto const command_line = process_command_line(argc, argv);
+        checker check;
+
+        // gݍ݂̃lbg[N
+        std::string const toy(toy_network);
+        auto const toy_graph = bn::serializer::bif_reader().parse(toy.data(), toy.data() + toy.size());
+        auto const& graph = std::get<0>(toy_graph);
+        auto const& database = std::get<1>(toy_graph);
+
+        check("bif (toy)", [&]
+        {
+            return bn::serializer::graph_difference(toy_graph, bn::serializer::bif().parse(toy.cbegin(), toy.cend()));
+        });
+        check("snapshot (toy)", [&]{ return snapshot_round_trip(toy_graph); });
+
+        // EvidenceCtC_C2̒_̏ɖ₢킹
+        std::vector<std::vector<std::pair<std::string, std::size_t>>> const evidences = {
+            {},
+            {{"E", 1}},
+            {{"D", 2}},
+            {{"B", 0}, {"E", 0}}
+        };
+        bn::inference::variable_elimination const ve(graph);
+        for(auto const& observed : evidences)
+        {
+            auto const evidence = make_evidence(graph, database, observed);
+            auto const expected = enumerate_posterior(graph, evidence);
+            std::string description;
+            for(auto const& select : observed)
+                description += (description.empty() ? "" : ", ") + select.first + " = " + std::to_string(select.second);
+            description = "(toy, evidence: " + (description.empty() ? std::string("none") : description) + ")";
+
+            check("ve " + description, [&]
+            {
+                return compare_posterior(graph, database,
+                    [&](bn::vertex_type const& node){ return ve.marginal(evidence, node); }, expected, 1e-12);
+            });
+
+            // 1XbhEŒ̃V[hȂ̂Ōʂ͌ID덷̓Tv\
+            check("lw " + description, [&]
+            {
+                bn::inference::parallel_likelihood_weighting lw(graph, 1);
+                lw.seed(0);
+                auto const posterior = lw(evidence, 200000);
+                return compare_posterior(graph, database,
+                    [&](bn::vertex_type const& node){ return posterior.at(node); }, expected, 0.01);
+            });
+        }
+
+        // B\̍(1s̃[hɂ܂钸_Ŏ)
+        check("reach (70 nodes, 3000 operations)", []{ return reachability_against_dfs(70, 3000, 0); });
+
+        // ^ꂽlbg[N
+        for(auto const& network : command_line.networks)
+        {
+            auto const dot = network.find_last_of('.');
+            auto const is_snapshot = dot != std::string::npos && network.compare(dot, std::string::npos, ".bnsnap") == 0;
+            if(!is_snapshot)
+            {
+                check("bif (" + network + ")", [&]
+                {
+                    return bn::serializer::graph_difference(
+                        bn::serializer::bif_reader().load(network), bn::serializer::load_library_bif(network));
+                });
+            }
+            check("snapshot (" + network + ")", [&]{ return snapshot_round_trip(bn::serializer::load_graph(network)); });
+        }
+
+        if(check.failed() != 0)
+        {
+            std::cerr << "error: " << check.failed() << " check(s) failed" << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cout << "All checks passed" << std::endl;
+    }
+    catch(std::exception const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
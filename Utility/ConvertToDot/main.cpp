@@ -9,9 +9,9 @@
 #include <boost/program_options/parsers.hpp>
 
 #include <bayesian/graph.hpp>
-#include <bayesian/serializer/bif.hpp>
 #include <bayesian/serializer/csv.hpp>
 #include <bayesian/serializer/dot.hpp>
+#include <Common/graph_snapshot.hpp>
 
 struct command_line_t {
     std::string const output;
@@ -56,16 +56,10 @@ int main(int argc, char* argv[])
     // R}hCp[X
     auto const command_line = process_command_line(argc, argv);
 
-    // Ott@CJgraph_dataɓ
-    std::ifstream ifs_graph(command_line.network);
-    std::string const graph_data{std::istreambuf_iterator<char>(ifs_graph), std::istreambuf_iterator<char>()};
-    ifs_graph.close();
-    std::cout << "Loaded Graph: Length = " << graph_data.size() << std::endl;
-
-    // graph_dataOtp[X
+    // Ott@Cǂݍ(.bnsnapȂXibvVbgCȊOBIF)
 	bn::graph_t graph;
     bn::database_t data;
-    std::tie(graph, data) = bn::serializer::bif().parse(graph_data.cbegin(), graph_data.cend());
+    std::tie(graph, data) = bn::serializer::load_graph(command_line.network);
     std::cout << "Parsed Graph: Num of Node = " << graph.vertex_list().size() << std::endl;
 
     // Nt@CȂC̃NԂɂ
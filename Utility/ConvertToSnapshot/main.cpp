@@ -0,0 +1,97 @@
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+#define BOOST_SPIRIT_INCLUDE_PHOENIX
+#include <boost/phoenix/phoenix.hpp>
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <boost/program_options/parsers.hpp>
+
+#include <bayesian/graph.hpp>
+#include <Common/graph_snapshot.hpp>
+
+struct command_line_t {
+    std::string const output;
+    std::string const network;
+    bool const check;
+};
+
+command_line_t process_command_line(int argc, char* argv[])
+{
+    boost::program_options::options_description opt("Option");
+    opt.add_options()
+        ("help,h",                                                  "Show this help")
+        ("output,o",  boost::program_options::value<std::string>(), "Output File(.bnsnap)  [optional: network path with .bnsnap]")
+        ("network,n", boost::program_options::value<std::string>(), "Network Input File    [required]")
+        ("check,c",                                                 "Compare the BIF with bn::serializer::bif and the saved snapshot with the input; fail on any difference");
+
+	boost::program_options::variables_map vm;
+	store(parse_command_line(argc, argv, opt), vm);
+	notify(vm);
+
+    if(vm.count("help"))
+    {
+        std::cout << opt << std::endl;
+        std::exit(0);
+    }
+
+    if(!vm.count("network"))
+    {
+        std::cerr << "Required: --network" << std::endl;
+        std::cerr << opt << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    auto const network = vm["network"].as<std::string>();
+    auto const check = vm.count("check") != 0;
+    if(vm.count("output"))
+        return { vm["output"].as<std::string>(), network, check };
+
+    // gq.bnsnapɒu
+    auto const dot = network.find_last_of('.');
+    auto const slash = network.find_last_of("/\\");
+    auto const stem = (dot != std::string::npos && (slash == std::string::npos || dot > slash)) ? network.substr(0, dot) : network;
+    return { stem + ".bnsnap", network, check };
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        // R}hCp[X
+        auto const command_line = process_command_line(argc, argv);
+        if(command_line.output == command_line.network)
+            throw std::runtime_error("error: Output path is the same as the network path (" + command_line.output + ")");
+
+        // Ott@Cǂݍ
+        bn::graph_t graph;
+        bn::database_t data;
+        auto const parser = command_line.check ? bn::serializer::bif_parser::check : bn::serializer::bif_parser::fast;
+        std::tie(graph, data) = bn::serializer::load_graph(command_line.network, parser);
+        std::cout << "Parsed Graph: Num of Node = " << graph.vertex_list().size() << std::endl;
+
+        // o
+        bn::serializer::graph_snapshot().save(command_line.output, graph, data);
+        std::cout << "Saved Snapshot: " << command_line.output << std::endl;
+
+        // oXibvVbgǂݒC͂Ɠm߂
+        if(command_line.check)
+        {
+            auto const difference = bn::serializer::graph_difference(
+                std::make_tuple(graph, data), bn::serializer::graph_snapshot().load(command_line.output), 0.0);
+            if(!difference.empty())
+                throw std::runtime_error("error: The saved snapshot differs from the input: " + difference);
+            std::cout << "Checked: the snapshot matches the input" << std::endl;
+        }
+    }
+    catch(std::exception const& e)
+    {
+        // Ǎ⏑o̎s(ꂽBIFXibvVbgCȂo͐Ȃ)͏IR[hŒm点
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -1,5 +1,7 @@
+#include <fstream>
 #include <iostream>
 #include <random>
+#include <unordered_set>
 
 #define BOOST_SPIRIT_INCLUDE_PHOENIX
 #include <boost/phoenix/phoenix.hpp>
@@ -11,10 +13,11 @@
 #include <bayesian/sampler.hpp>
 #include <bayesian/utility.hpp>
 #include <bayesian/inference/likelihood_weighting.hpp>
-#include <bayesian/serializer/bif.hpp>
 #include <bayesian/serializer/csv.hpp>
 #include <bayesian/serializer/dot.hpp>
 #include <bayesian/evaluation/transinformation.hpp>
+#include <Common/graph_diff.hpp>
+#include <Common/graph_snapshot.hpp>
 
 auto process_command_line(int argc, char* argv[])
     -> std::tuple<std::string, std::string, std::string, std::string>
@@ -54,14 +57,8 @@ auto process_command_line(int argc, char* argv[])
 
 std::tuple<bn::graph_t, bn::database_t> read_graph(std::string const& path)
 {
-    // Ott@CJgraph_dataɓ
-    std::ifstream ifs(path);
-    std::string const graph_data{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
-    ifs.close();
-    std::cout << "Loaded Graph: Length = " << graph_data.size() << std::endl;
-
-    // graph_dataOtp[X
-    auto data = bn::serializer::bif().parse(graph_data.cbegin(), graph_data.cend());
+    // Ott@Cǂݍ(.bnsnapȂXibvVbgCȊOBIF)
+    auto data = bn::serializer::load_graph(path);
     auto const& vertex_list = std::get<0>(data).vertex_list();
     std::cout << "Parsed Graph: Num of Node = " << vertex_list.size() << std::endl;
     
@@ -89,24 +86,14 @@ public:
         for(auto const& node : targ_graph.vertex_list())
             ost << "    " << get_node_identify(node) << " [label=\"" << data.node_name.at(node->id) << "\"];\n";
 
-        // GbWo
+        // GbWo(̃OtɌ킸ӂ͔j)
+        bn::graph_diff const diff(orig_graph, targ_graph);
+        std::unordered_set<bn::edge_type> const appeared(diff.appeared().begin(), diff.appeared().end());
         for(auto const& edge : targ_graph.edge_list())
         {
             auto const source = targ_graph.source(edge);
             auto const target = targ_graph.target(edge);
-            
-            bool is_exist = false;
-            for(auto const& orig_edge : orig_graph.edge_list())
-            {
-                if(
-                    (orig_graph.source(orig_edge) == source && orig_graph.target(orig_edge) == target) ||
-                    (orig_graph.source(orig_edge) == target && orig_graph.target(orig_edge) == source)
-                    )
-                {
-                    is_exist = true;
-                    break;
-                }
-            }
+            auto const is_exist = appeared.count(edge) == 0;
 
             ost << "    " << get_node_identify(source) << " -> " << get_node_identify(target);
             if(!is_exist) ost << " [style = dashed]";    
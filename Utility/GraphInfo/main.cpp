@@ -9,16 +9,18 @@
 #include <boost/program_options/parsers.hpp>
 
 #include <bayesian/graph.hpp>
-#include <bayesian/serializer/bif.hpp>
 #include <bayesian/serializer/csv.hpp>
 #include <bayesian/serializer/dot.hpp>
+#include <Common/graph_snapshot.hpp>
 
-std::string process_command_line(int argc, char* argv[])
+std::pair<std::string, bn::serializer::bif_parser> process_command_line(int argc, char* argv[])
 {
     boost::program_options::options_description opt("Option");
     opt.add_options()
         ("help,h",                                                  "Show this help")
-        ("network,n", boost::program_options::value<std::string>(), "Network Path");
+        ("network,n", boost::program_options::value<std::string>(), "Network Path")
+        ("check,c",                                                 "Also parse the BIF with bn::serializer::bif and fail if the results differ")
+        ("library-bif",                                             "Parse the BIF with bn::serializer::bif instead of the built-in reader");
 
 	boost::program_options::variables_map vm;
 	store(parse_command_line(argc, argv, opt), vm);
@@ -37,7 +39,11 @@ std::string process_command_line(int argc, char* argv[])
         std::exit(0);
     }
 
-    return vm["network"].as<std::string>();
+    auto const parser =
+        vm.count("check")       ? bn::serializer::bif_parser::check :
+        vm.count("library-bif") ? bn::serializer::bif_parser::library :
+                                  bn::serializer::bif_parser::fast;
+    return std::make_pair(vm["network"].as<std::string>(), parser);
 }
 
 std::pair<std::size_t, std::size_t> get_node_value_info(bn::graph_t const& graph)
@@ -84,19 +90,16 @@ std::size_t calc_freedom(bn::graph_t const& graph)
 int main(int argc, char* argv[])
 {
     // R}hCp[X
-    std::string const net_path = process_command_line(argc, argv);
+    std::string net_path;
+    bn::serializer::bif_parser parser;
+    std::tie(net_path, parser) = process_command_line(argc, argv);
 
-    // Ott@CJgraph_dataɓ
-    std::ifstream ifs_graph(net_path);
-    std::string const graph_data{std::istreambuf_iterator<char>(ifs_graph), std::istreambuf_iterator<char>()};
-    ifs_graph.close();
-    std::cout << "Loaded Graph: Length = " << graph_data.size() << std::endl;
-
-    // graph_dataOtp[X
+    // Ott@Cǂݍ(.bnsnapȂXibvVbgCȊOBIF)
 	bn::graph_t graph;
     bn::database_t data;
-    std::tie(graph, data) = bn::serializer::bif().parse(graph_data.cbegin(), graph_data.cend());
+    std::tie(graph, data) = bn::serializer::load_graph(net_path, parser);
     std::cout << "Parsed Graph: Num of Node = " << graph.vertex_list().size() << std::endl;
+    if(parser == bn::serializer::bif_parser::check) std::cout << "Checked: bif_reader matches bn::serializer::bif" << std::endl;
 
     auto const valable_info = get_node_value_info(graph);
     auto const in_degree = calc_in_degree(graph);